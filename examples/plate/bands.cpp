@@ -0,0 +1,189 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "bands.h"
+#include "jacobi.h"
+#include "timer.h"
+
+// One thread's contribution to the residual of a sweep, padded so that
+// threads storing their results don't share a cache line
+struct PartialResidual {
+	Residual value;
+	char pad[64 - sizeof(Residual)];
+};
+
+// State shared by all of the threads
+struct Shared {
+	const BandSweeps *sweeps;
+	const SolveParams *params;
+	pthread_barrier_t barrier;
+
+	// the threads wait here until all of them have been started
+	// (go = 1), or until starting one of them failed (go = -1)
+	pthread_mutex_t gate_lock;
+	pthread_cond_t gate;
+	int go;
+
+	// partial residuals for even and odd sweeps: slot
+	// (iteration % 2) * nthreads + thread
+	PartialResidual *partial;
+
+	// filled in by thread 0 when the threads finish
+	long iterations;
+	double residual;
+	double residual_l2;
+};
+
+// One thread and its band
+struct Band {
+	pthread_t thread;
+	int index;
+	Shared *shared;
+};
+
+// Each thread sweeps its own band.  The cells just outside the band
+// belong to the neighboring threads, so the barrier at the end of every
+// sweep is what makes those boundary cells (the "halo") up to date
+// before the next sweep reads them.  On sweeps where the residual is
+// measured, every thread then computes the same global residual from
+// the per-thread partials, so all of them agree on when to stop
+// without another barrier.
+static void *band_main(void *arg) {
+	Band *band = (Band *) arg;
+	Shared *shared = band->shared;
+	const BandSweeps *sweeps = shared->sweeps;
+	const SolveParams *params = shared->params;
+	int n = sweeps->nthreads;
+
+	pthread_mutex_lock(&shared->gate_lock);
+	while (shared->go == 0) {
+		pthread_cond_wait(&shared->gate, &shared->gate_lock);
+	}
+	bool abort = shared->go < 0;
+	pthread_mutex_unlock(&shared->gate_lock);
+	if (abort) {
+		return NULL;
+	}
+
+	if (sweeps->start != NULL) {
+		sweeps->start(sweeps->arg, band->index);
+	}
+
+	long iterations = 0;
+	double residual = 0.0;
+	double residual_l2 = 0.0;
+	while (iterations < params->max_iter) {
+		PartialResidual *partial = &shared->partial[(iterations % 2) * n];
+		bool check = jacobi_check_due(iterations, iterations+1, params->max_iter,
+			params->check_every);
+
+		sweeps->sweep(sweeps->arg, band->index, iterations % 2,
+			check ? &partial[band->index].value : NULL);
+
+		pthread_barrier_wait(&shared->barrier);
+		iterations++;
+
+		if (check) {
+			// The slots for the other parity are written during the next
+			// sweep, and nobody can get two sweeps ahead of us because of
+			// the barrier, so these values are stable while we read them.
+			residual = 0.0;
+			double sum_sq = 0.0;
+			for (int k = 0; k < n; k++) {
+				if (partial[k].value.max > residual) {
+					residual = partial[k].value.max;
+				}
+				sum_sq += partial[k].value.sum_sq;
+			}
+			residual_l2 = sqrt(sum_sq);
+
+			if (band->index == 0 && params->monitor != NULL) {
+				params->monitor(iterations, residual, residual_l2, params->monitor_arg);
+			}
+			if (residual_converged(params, residual, residual_l2)) {
+				break;
+			}
+		}
+	}
+
+	if (band->index == 0) {
+		shared->iterations = iterations;
+		shared->residual = residual;
+		shared->residual_l2 = residual_l2;
+	}
+	return NULL;
+}
+
+// Repeat the sweeps, each shared by sweeps->nthreads threads (the
+// calling thread doing band 0), until the residual (in the norm
+// params->norm) is at most params->tol, or params->max_iter sweeps
+// have been done, measuring it every params->check_every sweeps.
+// Fills in the iterations, residuals, time and number of threads of
+// result; after an odd number of sweeps the answer is in buffer 1.
+// Returns false if memory could not be allocated or the threads could
+// not be started.
+bool bands_solve(const BandSweeps *sweeps, const SolveParams *params, SolveResult *result) {
+	int nthreads = sweeps->nthreads;
+
+	Shared shared;
+	shared.sweeps = sweeps;
+	shared.params = params;
+	shared.partial = (PartialResidual *) malloc(2 * nthreads * sizeof(PartialResidual));
+	Band *bands = (Band *) malloc(nthreads * sizeof(Band));
+	if (shared.partial == NULL || bands == NULL) {
+		free(shared.partial);
+		free(bands);
+		return false;
+	}
+	pthread_barrier_init(&shared.barrier, NULL, nthreads);
+	pthread_mutex_init(&shared.gate_lock, NULL);
+	pthread_cond_init(&shared.gate, NULL);
+	shared.go = 0;
+
+	for (int k = 0; k < nthreads; k++) {
+		bands[k].index = k;
+		bands[k].shared = &shared;
+	}
+
+	double start = wall_time();
+
+	int started = 0;
+	bool ok = true;
+	for (int k = 1; k < nthreads; k++) {
+		if (pthread_create(&bands[k].thread, NULL, band_main, &bands[k]) != 0) {
+			ok = false;
+			break;
+		}
+		started++;
+	}
+
+	// open the gate (or tell the threads to give up)
+	pthread_mutex_lock(&shared.gate_lock);
+	shared.go = ok ? 1 : -1;
+	pthread_cond_broadcast(&shared.gate);
+	pthread_mutex_unlock(&shared.gate_lock);
+
+	if (ok) {
+		// the calling thread does band 0
+		band_main(&bands[0]);
+	}
+	for (int k = 1; k <= started; k++) {
+		pthread_join(bands[k].thread, NULL);
+	}
+
+	result->seconds = wall_time() - start;
+
+	if (ok) {
+		result->iterations = shared.iterations;
+		result->residual = shared.residual;
+		result->residual_l2 = shared.residual_l2;
+		result->nthreads = nthreads;
+	}
+
+	pthread_barrier_destroy(&shared.barrier);
+	pthread_mutex_destroy(&shared.gate_lock);
+	pthread_cond_destroy(&shared.gate);
+	free(shared.partial);
+	free(bands);
+	return ok;
+}
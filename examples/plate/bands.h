@@ -0,0 +1,27 @@
+#ifndef BANDS_H
+#define BANDS_H
+
+#include "solver.h"
+#include "stencil.h"
+
+// Repeated sweeps split between threads, each of which always updates
+// the same band of the cells.  The cells are in two buffers, and each
+// sweep reads one and writes the other, so the sweeps alternate
+// between them.
+struct BandSweeps {
+	int nthreads;
+
+	// Called by each thread once, before its first sweep, with its band
+	// number (0..nthreads-1); may be NULL
+	void (*start)(void *arg, int band);
+
+	// Sweep one band from buffer from (0 or 1) into the other one.
+	// Unless res is NULL, it is set to the residual of the band.
+	void (*sweep)(void *arg, int band, int from, Residual *res);
+
+	void *arg;        // passed to start and sweep
+};
+
+bool bands_solve(const BandSweeps *sweeps, const SolveParams *params, SolveResult *result);
+
+#endif // BANDS_H
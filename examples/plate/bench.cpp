@@ -0,0 +1,206 @@
+// Benchmark the plate sweeps over a range of plate sizes.
+//
+//   bench.exe LEFT RIGHT TOP BOTTOM [-n MIN] [-N MAX] [-k SWEEPS] [-j THREADS]
+//             [-f csv|json]
+//
+// Square plates from MIN to MAX cells across (doubling each time, so
+// from L1-cache sized up to far bigger than any cache) are each run
+// for SWEEPS sweeps with every variant of the solver.  The results
+// are printed as CSV (or JSON) with one line per variant and size:
+// time per cell update, effective memory bandwidth, floating point
+// rate, and arithmetic intensity (flops per byte), which is what is
+// needed to place each run on a roofline plot.
+//
+// The bandwidth and flop rate are computed from the minimum work a
+// sweep has to do: each interior cell is read once and written once,
+// and takes 4 flops (3 additions and a multiplication) for Jacobi or
+// 7 for SOR.  Nothing is read from standard input.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "grid.h"
+#include "solver.h"
+#include "stencil.h"
+
+// each measurement is repeated until it has taken at least this long
+#define MIN_SECONDS 0.2
+
+// One way of running the sweeps
+struct Variant {
+	const char *name;
+	int method;
+	int precision;
+	int simd;
+	int tile_cols;
+	int time_steps;
+	bool threaded;      // use the -j thread count
+	double flops;       // per interior cell per sweep
+	double bytes;       // per interior cell per sweep
+};
+
+static const Variant variants[] = {
+	{ "jacobi-scalar",   METHOD_JACOBI, PRECISION_DOUBLE, SIMD_SCALAR, 0,         0, false, 4, 16 },
+	{ "jacobi-simd",     METHOD_JACOBI, PRECISION_DOUBLE, SIMD_AUTO,   0,         0, false, 4, 16 },
+	{ "jacobi-tiled",    METHOD_JACOBI, PRECISION_DOUBLE, SIMD_AUTO,   TILE_AUTO, 0, false, 4, 16 },
+	{ "jacobi-temporal", METHOD_JACOBI, PRECISION_DOUBLE, SIMD_AUTO,   0,         8, false, 4, 16 },
+	{ "jacobi-threads",  METHOD_JACOBI, PRECISION_DOUBLE, SIMD_AUTO,   0,         0, true,  4, 16 },
+	{ "jacobi-float",    METHOD_JACOBI, PRECISION_FLOAT,  SIMD_AUTO,   0,         0, false, 4, 8 },
+	{ "sor",             METHOD_SOR,    PRECISION_DOUBLE, SIMD_SCALAR, 0,         0, false, 7, 16 },
+};
+
+#define NUM_VARIANTS (int) (sizeof(variants) / sizeof(variants[0]))
+
+struct BenchOptions {
+	double left, right, top, bottom;
+	int min_size;
+	int max_size;
+	int sweeps;
+	int nthreads;
+	bool json;
+};
+
+bool parse_bench_options(int argc, char *argv[], BenchOptions *opts);
+bool run_variant(const Variant *v, const BenchOptions *opts, int size, bool first);
+
+int main(int argc, char *argv[]) {
+	BenchOptions opts;
+	if (!parse_bench_options(argc, argv, &opts)) {
+		printf("Usage: bench.exe LEFT RIGHT TOP BOTTOM [-n MIN] [-N MAX] [-k SWEEPS] [-j THREADS]\n");
+		printf("                 [-f csv|json]\n");
+		printf("  -n MIN      smallest plate size (default 32)\n");
+		printf("  -N MAX      largest plate size (default 4096)\n");
+		printf("  -k SWEEPS   sweeps per measurement (default 20)\n");
+		printf("  -j THREADS  threads for the jacobi-threads variant (default 4)\n");
+		printf("  -f FORMAT   csv (default) or json\n");
+		return 1;
+	}
+
+	if (opts.json) {
+		printf("[\n");
+	} else {
+		printf("variant,simd,rows,cols,sweeps,reps,seconds,ns_per_cell,gb_per_s,"
+			"gflop_per_s,flops_per_byte\n");
+	}
+
+	bool first = true;
+	for (int size = opts.min_size; size <= opts.max_size; size *= 2) {
+		for (int v = 0; v < NUM_VARIANTS; v++) {
+			if (variants[v].threaded && opts.nthreads <= 1) {
+				continue;
+			}
+			if (!run_variant(&variants[v], &opts, size, first)) {
+				fprintf(stderr, "%s: could not run on a %ix%i plate\n",
+					variants[v].name, size, size);
+				continue;
+			}
+			first = false;
+		}
+		fflush(stdout);
+	}
+
+	if (opts.json) {
+		printf("\n]\n");
+	}
+
+	return 0;
+}
+
+// Time one variant on a size by size plate, and print one result line.
+// Returns false if the solver could not run.
+bool run_variant(const Variant *v, const BenchOptions *opts, int size, bool first) {
+	Grid plate;
+	if (!grid_alloc(&plate, size, size)) {
+		return false;
+	}
+
+	SolveParams params;
+	solve_params_init(&params);
+	params.method = v->method;
+	params.precision = v->precision;
+	params.simd = v->simd;
+	params.tile_cols = v->tile_cols;
+	params.time_steps = v->time_steps;
+	params.nthreads = v->threaded ? opts->nthreads : 1;
+	params.tol = -1.0;     // never converged: always do every sweep
+	params.max_iter = opts->sweeps;
+
+	// repeat from the same starting plate until enough time has passed
+	double seconds = 0.0;
+	int reps = 0;
+	SolveResult result;
+	while (seconds < MIN_SECONDS) {
+		grid_init(&plate, opts->left, opts->right, opts->top, opts->bottom);
+		if (!solve(&plate, &params, &result)) {
+			grid_free(&plate);
+			return false;
+		}
+		seconds += result.seconds;
+		reps++;
+	}
+	grid_free(&plate);
+
+	double updates = (double) (size-2) * (size-2) * opts->sweeps * reps;
+	double ns_per_cell = seconds / updates * 1e9;
+	double gb_per_s = updates * v->bytes / seconds * 1e-9;
+	double gflop_per_s = updates * v->flops / seconds * 1e-9;
+	double intensity = v->flops / v->bytes;
+	const char *simd = simd_name(result.simd);
+
+	if (opts->json) {
+		printf("%s  {\"variant\": \"%s\", \"simd\": \"%s\", \"rows\": %i, \"cols\": %i, "
+			"\"sweeps\": %i, \"reps\": %i, \"seconds\": %.6lf, \"ns_per_cell\": %.4lf, "
+			"\"gb_per_s\": %.3lf, \"gflop_per_s\": %.3lf, \"flops_per_byte\": %.4lf}",
+			first ? "" : ",\n", v->name, simd, size, size, opts->sweeps, reps, seconds,
+			ns_per_cell, gb_per_s, gflop_per_s, intensity);
+	} else {
+		printf("%s,%s,%i,%i,%i,%i,%.6lf,%.4lf,%.3lf,%.3lf,%.4lf\n", v->name, simd,
+			size, size, opts->sweeps, reps, seconds, ns_per_cell, gb_per_s,
+			gflop_per_s, intensity);
+	}
+	return true;
+}
+
+// Read the command line arguments into opts.
+// Returns false if they don't make sense.
+bool parse_bench_options(int argc, char *argv[], BenchOptions *opts) {
+	if (argc < 5) {
+		return false;
+	}
+	opts->left = atof(argv[1]);
+	opts->right = atof(argv[2]);
+	opts->top = atof(argv[3]);
+	opts->bottom = atof(argv[4]);
+	opts->min_size = 32;
+	opts->max_size = 4096;
+	opts->sweeps = 20;
+	opts->nthreads = 4;
+	opts->json = false;
+
+	for (int i = 5; i < argc; i++) {
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-n") == 0) {
+			opts->min_size = atoi(value);
+		} else if (strcmp(argv[i], "-N") == 0) {
+			opts->max_size = atoi(value);
+		} else if (strcmp(argv[i], "-k") == 0) {
+			opts->sweeps = atoi(value);
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->nthreads = atoi(value);
+		} else if (strcmp(argv[i], "-f") == 0) {
+			if (strcmp(value, "json") == 0) {
+				opts->json = true;
+			} else if (strcmp(value, "csv") != 0) {
+				return false;
+			}
+		} else {
+			return false;
+		}
+		i++;
+	}
+
+	return opts->min_size >= 3 && opts->max_size >= opts->min_size && opts->sweeps >= 1;
+}
@@ -0,0 +1,251 @@
+// Simulate heat transfer in a rectangular block: the 3D version of
+// plate.exe.  Each interior cell is repeatedly replaced by the average
+// of its six neighbors until the temperatures stop changing.
+//
+//   block.exe [-x NX] [-y NY] [-z NZ] [-t TOL] [-m MAXITER] [-n max|l2]
+//             [-k K] [-T WIDTH] [-R ROWS|auto] [-s scalar|avx2|avx512|auto]
+//             [-j THREADS] [-p] [-b SWEEPS]
+//
+// The six face temperatures are read from standard input, e.g.
+//
+//   echo 100 0 50 25 75 10 | ./block.exe -x 256 -y 256 -z 256 -j 4
+//
+// The sweeps go through the block in 2.5D tiles (see jacobi3d_sweep)
+// sized to fit in cache, unless -R 0 asks for plain layer-by-layer
+// sweeps.  -b SWEEPS times SWEEPS plain and tiled sweeps instead of
+// solving, and reports the effective memory bandwidth of each (so it
+// can't be given with -R 0).
+// -p prints the middle layer of the block (for blocks up to 20x20).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "jacobi3d.h"
+#include "solver.h"
+#include "stencil.h"
+#include "timer.h"
+#include "volume.h"
+
+// layers wider or longer than this are not printed
+#define MAX_PRINT 20
+
+struct Options {
+	int nx;
+	int ny;
+	int nz;
+	SolveParams params;
+	int bandwidth_sweeps;
+	bool print;
+};
+
+bool parse_options(int argc, char *argv[], Options *opts);
+void usage(void);
+bool report_bandwidth(const Volume *block, const SolveParams *params, int sweeps);
+
+int main(int argc, char *argv[]) {
+	Options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+
+	Faces faces;
+
+	printf("Left temperature: ");
+	scanf("%lf", &faces.left);
+	printf("Right temperature: ");
+	scanf("%lf", &faces.right);
+	printf("Front temperature: ");
+	scanf("%lf", &faces.front);
+	printf("Back temperature: ");
+	scanf("%lf", &faces.back);
+	printf("Bottom temperature: ");
+	scanf("%lf", &faces.bottom);
+	printf("Top temperature: ");
+	scanf("%lf", &faces.top);
+
+	Volume block;
+	if (!volume_alloc(&block, opts.nx, opts.ny, opts.nz)) {
+		printf("Not enough memory for a %ix%ix%i block\n", opts.nx, opts.ny, opts.nz);
+		return 1;
+	}
+	volume_init(&block, &faces);
+
+	if (opts.bandwidth_sweeps > 0) {
+		bool ok = report_bandwidth(&block, &opts.params, opts.bandwidth_sweeps);
+		volume_free(&block);
+		if (!ok) {
+			printf("Not enough memory for a %ix%ix%i block\n", opts.nx, opts.ny, opts.nz);
+			return 1;
+		}
+		return 0;
+	}
+
+	SolveResult result;
+	if (!jacobi3d_solve(&block, &opts.params, &result)) {
+		printf("Could not run the solver\n");
+		volume_free(&block);
+		return 1;
+	}
+
+	if (opts.print && opts.nx <= MAX_PRINT && opts.ny <= MAX_PRINT) {
+		printf("Middle layer (z = %i):\n", opts.nz / 2);
+		volume_print_layer(&block, opts.nz / 2);
+	}
+
+	printf("Block:      %ix%ix%i\n", opts.nx, opts.ny, opts.nz);
+	printf("Iterations: %li\n", result.iterations);
+	printf("Residual:   %g (L2 %g)\n", result.residual, result.residual_l2);
+	printf("Time:       %.3lf s\n", result.seconds);
+	printf("SIMD:       %s\n", simd_name(result.simd));
+	if (result.nthreads > 1) {
+		printf("Threads:    %i\n", result.nthreads);
+	}
+	if (result.tile_rows > 0) {
+		printf("Tiles:      %i rows by %i columns\n", result.tile_rows,
+			result.tile_cols > 0 ? result.tile_cols : opts.nx-2);
+	}
+
+	volume_free(&block);
+
+	return 0;
+}
+
+// Read the command line arguments into opts.
+// Returns false if they don't make sense.
+bool parse_options(int argc, char *argv[], Options *opts) {
+	opts->nx = 10;
+	opts->ny = 10;
+	opts->nz = 10;
+	solve_params_init(&opts->params);
+	opts->params.tile_rows = TILE_AUTO;
+	opts->bandwidth_sweeps = 0;
+	opts->print = false;
+
+	for (int i = 1; i < argc; i++) {
+		// options without a value
+		if (strcmp(argv[i], "-p") == 0) {
+			opts->print = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-x") == 0) {
+			opts->nx = atoi(value);
+		} else if (strcmp(argv[i], "-y") == 0) {
+			opts->ny = atoi(value);
+		} else if (strcmp(argv[i], "-z") == 0) {
+			opts->nz = atoi(value);
+		} else if (strcmp(argv[i], "-t") == 0) {
+			opts->params.tol = atof(value);
+		} else if (strcmp(argv[i], "-m") == 0) {
+			opts->params.max_iter = atol(value);
+		} else if (strcmp(argv[i], "-n") == 0) {
+			opts->params.norm = norm_from_name(value);
+			if (opts->params.norm < 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-k") == 0) {
+			opts->params.check_every = atoi(value);
+		} else if (strcmp(argv[i], "-T") == 0) {
+			opts->params.tile_cols = atoi(value);
+		} else if (strcmp(argv[i], "-R") == 0) {
+			opts->params.tile_rows = (strcmp(value, "auto") == 0) ? TILE_AUTO : atoi(value);
+		} else if (strcmp(argv[i], "-s") == 0) {
+			if (!simd_from_name(value, &opts->params.simd)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->params.nthreads = atoi(value);
+		} else if (strcmp(argv[i], "-b") == 0) {
+			opts->bandwidth_sweeps = atoi(value);
+		} else {
+			return false;
+		}
+		i++;
+	}
+
+	// -b with -R 0 would time plain sweeps against plain sweeps
+	return opts->nx >= 3 && opts->ny >= 3 && opts->nz >= 3 && opts->params.max_iter >= 0
+		&& opts->params.nthreads >= 1 && opts->params.check_every >= 1
+		&& (opts->params.tile_rows >= 0 || opts->params.tile_rows == TILE_AUTO)
+		&& !(opts->bandwidth_sweeps > 0 && opts->params.tile_rows == 0);
+}
+
+void usage(void) {
+	printf("Usage: block.exe [-x NX] [-y NY] [-z NZ] [-t TOL] [-m MAXITER] [-n max|l2]\n");
+	printf("                 [-k K] [-T WIDTH] [-R ROWS|auto] [-s scalar|avx2|avx512|auto]\n");
+	printf("                 [-j THREADS] [-p] [-b SWEEPS]\n");
+	printf("  -x NX       number of columns (default 10)\n");
+	printf("  -y NY       number of rows (default 10)\n");
+	printf("  -z NZ       number of layers (default 10)\n");
+	printf("  -t TOL      stop when the residual is at most TOL (default 1e-4)\n");
+	printf("  -m MAXITER  stop after at most MAXITER sweeps (default 1000000)\n");
+	printf("  -n NORM     measure the residual by the largest change (max, the default)\n");
+	printf("              or by the L2 norm of the changes (l2)\n");
+	printf("  -k K        only measure the residual every K sweeps (default 1)\n");
+	printf("  -T WIDTH    width of the 2.5D tiles (default: whole rows)\n");
+	printf("  -R ROWS     height of the 2.5D tiles, 0 for plain sweeps, or \"auto\" to\n");
+	printf("              fit them in cache (the default)\n");
+	printf("  -s SIMD     instruction set for the sweeps (default: widest supported)\n");
+	printf("  -j THREADS  number of threads, each sweeping a slab of layers (default 1)\n");
+	printf("  -p          print the middle layer (blocks up to %ix%i)\n", MAX_PRINT, MAX_PRINT);
+	printf("  -b SWEEPS   time SWEEPS plain and tiled sweeps and report bandwidth\n");
+	printf("              (not with -R 0)\n");
+}
+
+// Time the given number of plain sweeps and 2.5D tiled sweeps of the
+// block on one thread, and print the effective memory bandwidth of
+// each.  As in plate.exe, a sweep has to move at least 16 bytes per
+// interior cell; fetching layers from memory more than once shows up
+// as lower bandwidth.
+// Returns false if the work buffers could not be allocated.
+bool report_bandwidth(const Volume *block, const SolveParams *params, int sweeps) {
+	Volume a, b;
+	if (!volume_alloc(&a, block->nx, block->ny, block->nz)) {
+		return false;
+	}
+	if (!volume_alloc(&b, block->nx, block->ny, block->nz)) {
+		volume_free(&a);
+		return false;
+	}
+	volume_copy(&a, block);
+	volume_copy(&b, block);
+
+	Residual res;
+	RowUpdate7 update = row_update7(params->simd);
+	int tile_cols = params->tile_cols > 0 ? params->tile_cols : 0;
+	int tile_rows = params->tile_rows;
+	if (tile_rows == TILE_AUTO) {
+		tile_rows = jacobi3d_auto_rows(block, tile_cols);
+	}
+
+	double bytes = 16.0 * (block->nx-2) * (block->ny-2) * (block->nz-2) * sweeps;
+
+	double start = wall_time();
+	for (int k = 0; k < sweeps; k++) {
+		jacobi3d_sweep(&a, &b, 1, block->nz-1, 0, 0, update, &res);
+		volume_swap(&a, &b);
+	}
+	double plain = wall_time() - start;
+
+	start = wall_time();
+	for (int k = 0; k < sweeps; k++) {
+		jacobi3d_sweep(&a, &b, 1, block->nz-1, tile_cols, tile_rows, update, &res);
+		volume_swap(&a, &b);
+	}
+	double tiled = wall_time() - start;
+
+	printf("SIMD:             %s\n", simd_name(simd_resolve(params->simd)));
+	printf("Plain:            %8.3lf s  %7.2lf GB/s\n", plain, bytes / plain * 1e-9);
+	printf("2.5D tiles:       %8.3lf s  %7.2lf GB/s  (%i rows by %i columns)\n", tiled,
+		bytes / tiled * 1e-9, tile_rows > 0 ? tile_rows : block->ny-2,
+		tile_cols > 0 ? tile_cols : block->nx-2);
+
+	volume_free(&a);
+	volume_free(&b);
+	return true;
+}
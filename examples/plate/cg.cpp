@@ -0,0 +1,261 @@
+#include <math.h>
+#include "cg.h"
+#include "stencil.h"
+#include "timer.h"
+
+// The steady-state temperatures are the solution of a linear system:
+// for every interior cell,
+//
+//   4 u[i][j] - (sum of its interior neighbors) = (sum of its edge neighbors)
+//
+// or A u = b, where A is the 5-point Laplacian on the interior.  A is
+// symmetric and positive definite, so the conjugate gradient method
+// can solve it, in about as many iterations as the plate is wide
+// instead of the plate's area as with Jacobi sweeps.
+//
+// A is never stored.  Multiplying by it is one pass of the same
+// 4-neighbor stencil as a sweep.  The direction vectors p keep a ring
+// of zeros where the plate's edges are, so the stencil can be applied
+// to every interior cell without special cases.  The residual
+// r = b - A u is computed from the plate itself, edges included, as
+// (sum of neighbors) - 4 u, which is 4 times how far each cell is from
+// the average of its neighbors.  So r / 4 is reported as the residual,
+// to compare with the other methods.
+
+// Compute q = A p on the interior of the grids.
+// Returns the dot product of p and q.
+static double apply_laplacian(const Grid *p, Grid *q) {
+	double pq = 0.0;
+	for (int i = 1; i < p->nrows-1; i++) {
+		for (int j = 1; j < p->ncols-1; j++) {
+			double sum_neighbors = CELL(p, i-1, j) + CELL(p, i+1, j)
+				+ CELL(p, i, j-1) + CELL(p, i, j+1);
+			double value = 4.0 * CELL(p, i, j) - sum_neighbors;
+			CELL(q, i, j) = value;
+			pq += CELL(p, i, j) * value;
+		}
+	}
+	return pq;
+}
+
+// r = b - A u, computed directly from the plate
+static void compute_residual(const Grid *plate, Grid *r) {
+	for (int i = 1; i < plate->nrows-1; i++) {
+		for (int j = 1; j < plate->ncols-1; j++) {
+			double sum_neighbors = CELL(plate, i-1, j) + CELL(plate, i+1, j)
+				+ CELL(plate, i, j-1) + CELL(plate, i, j+1);
+			CELL(r, i, j) = sum_neighbors - 4.0 * CELL(plate, i, j);
+		}
+	}
+}
+
+// Largest |r| and the sum of r^2 over the interior
+static Residual measure(const Grid *r) {
+	Residual res = { 0.0, 0.0 };
+	for (int i = 1; i < r->nrows-1; i++) {
+		for (int j = 1; j < r->ncols-1; j++) {
+			double value = CELL(r, i, j);
+			if (fabs(value) > res.max) {
+				res.max = fabs(value);
+			}
+			res.sum_sq += value * value;
+		}
+	}
+	return res;
+}
+
+// Incomplete Cholesky factorization with no fill-in, IC(0): A is
+// approximated by (D + L) D^-1 (D + L)^T, where L is the part of A below
+// the diagonal (a -1 for the neighbors above and to the left) and the
+// diagonal D is chosen so the approximation has A's diagonal:
+//
+//   d[i][j] = 4 - 1 / d[i-1][j] - 1 / d[i][j-1]
+//
+// (leaving out neighbors on the edge).  Only d needs to be stored, and
+// it is stored as 1/d, since it is only ever divided by.
+static void ic_factor(Grid *inv_d) {
+	for (int i = 1; i < inv_d->nrows-1; i++) {
+		for (int j = 1; j < inv_d->ncols-1; j++) {
+			double value = 4.0;
+			if (i > 1) {
+				value -= CELL(inv_d, i-1, j);
+			}
+			if (j > 1) {
+				value -= CELL(inv_d, i, j-1);
+			}
+			CELL(inv_d, i, j) = 1.0 / value;
+		}
+	}
+}
+
+// z = M^-1 r for the chosen preconditioner.  For Jacobi, M is the
+// diagonal of A, which is 4 everywhere, so this only scales r (and CG
+// takes exactly the same steps as without a preconditioner).  For
+// IC(0), it is a forward substitution with D + L, then a backward one
+// with (D + L)^T, each walking the plate in order so that the
+// neighbors it needs are already done.  The ring of z must be 0.
+// Returns the dot product of r and z, which CG needs next.
+static double precondition(int preconditioner, const Grid *r, Grid *z, const Grid *inv_d) {
+	double rz = 0.0;
+
+	if (preconditioner != PRECOND_IC) {
+		for (int i = 1; i < r->nrows-1; i++) {
+			for (int j = 1; j < r->ncols-1; j++) {
+				CELL(z, i, j) = 0.25 * CELL(r, i, j);
+				rz += CELL(r, i, j) * CELL(z, i, j);
+			}
+		}
+		return rz;
+	}
+
+	// (D + L) y = r, with y stored in z
+	for (int i = 1; i < r->nrows-1; i++) {
+		for (int j = 1; j < r->ncols-1; j++) {
+			CELL(z, i, j) = (CELL(r, i, j) + CELL(z, i-1, j) + CELL(z, i, j-1))
+				* CELL(inv_d, i, j);
+		}
+	}
+
+	// (D + L)^T z = D y
+	for (int i = r->nrows-2; i >= 1; i--) {
+		for (int j = r->ncols-2; j >= 1; j--) {
+			CELL(z, i, j) += (CELL(z, i+1, j) + CELL(z, i, j+1)) * CELL(inv_d, i, j);
+			rz += CELL(r, i, j) * CELL(z, i, j);
+		}
+	}
+	return rz;
+}
+
+// Solve the plate with preconditioned conjugate gradients until the
+// residual (in the norm params->norm, of r / 4 as explained above) is
+// at most params->tol, or params->max_iter iterations have been done.
+// The residual checked, and reported, is the true residual b - A u of
+// the answer, not the one updated along the way; if the tolerance is
+// below what rounding lets CG reach, it stops once restarting no longer
+// brings the true residual down, with the residual above params->tol.
+// params->preconditioner picks Jacobi or IC(0).  The plate is updated
+// in place, and four more grids are needed (five with IC(0)).
+// Returns false if memory could not be allocated.
+bool cg_solve(Grid *plate, const SolveParams *params, SolveResult *result) {
+	Grid r, z, p, q, inv_d;
+	int nrows = plate->nrows, ncols = plate->ncols;
+	bool ic = params->preconditioner == PRECOND_IC;
+
+	r.cells = z.cells = p.cells = q.cells = inv_d.cells = NULL;
+	bool ok = grid_alloc(&r, nrows, ncols) && grid_alloc(&z, nrows, ncols)
+		&& grid_alloc(&p, nrows, ncols) && grid_alloc(&q, nrows, ncols)
+		&& (!ic || grid_alloc(&inv_d, nrows, ncols));
+	if (!ok) {
+		grid_free(&r);
+		grid_free(&z);
+		grid_free(&p);
+		grid_free(&q);
+		grid_free(&inv_d);
+		return false;
+	}
+
+	double start = wall_time();
+
+	// the rings of z and p must stay 0 (see above)
+	grid_fill(&z, 0.0);
+	grid_fill(&p, 0.0);
+	if (ic) {
+		ic_factor(&inv_d);
+	}
+
+	compute_residual(plate, &r);
+	Residual res = measure(&r);
+	double rz = precondition(params->preconditioner, &r, &z, &inv_d);
+	grid_copy(&p, &z);
+
+	result->iterations = 0;
+	result->residual = res.max / 4.0;
+	result->residual_l2 = sqrt(res.sum_sq) / 4.0;
+	bool exact = true;    // r is the true residual, not the updated one
+	double restart_residual = HUGE_VAL;   // true residual at the last restart
+	while (result->iterations < params->max_iter) {
+		if (residual_converged(params, result->residual, result->residual_l2)) {
+			if (exact) {
+				break;
+			}
+
+			// The updated residual drifts away from the true one through
+			// rounding, so it is only believed if the true one agrees.
+			// If it doesn't, start over from the true residual, unless
+			// that didn't help last time.
+			compute_residual(plate, &r);
+			res = measure(&r);
+			result->residual = res.max / 4.0;
+			result->residual_l2 = sqrt(res.sum_sq) / 4.0;
+			exact = true;
+			double true_residual = (params->norm == NORM_L2) ? result->residual_l2
+				: result->residual;
+			if (residual_converged(params, result->residual, result->residual_l2)
+					|| true_residual >= restart_residual) {
+				break;
+			}
+			restart_residual = true_residual;
+			rz = precondition(params->preconditioner, &r, &z, &inv_d);
+			grid_copy(&p, &z);
+		}
+
+		double pq = apply_laplacian(&p, &q);
+		double alpha = rz / pq;
+
+		// step along p, and update the residual to match
+		res.max = 0.0;
+		res.sum_sq = 0.0;
+		for (int i = 1; i < nrows-1; i++) {
+			for (int j = 1; j < ncols-1; j++) {
+				CELL(plate, i, j) += alpha * CELL(&p, i, j);
+				double value = CELL(&r, i, j) - alpha * CELL(&q, i, j);
+				CELL(&r, i, j) = value;
+				if (fabs(value) > res.max) {
+					res.max = fabs(value);
+				}
+				res.sum_sq += value * value;
+			}
+		}
+		result->iterations++;
+		exact = false;
+
+		result->residual = res.max / 4.0;
+		result->residual_l2 = sqrt(res.sum_sq) / 4.0;
+		if (params->monitor != NULL) {
+			params->monitor(result->iterations, result->residual, result->residual_l2,
+				params->monitor_arg);
+		}
+
+		// next direction: the preconditioned residual, made conjugate
+		// to the previous directions
+		double rz_next = precondition(params->preconditioner, &r, &z, &inv_d);
+		double beta = rz_next / rz;
+		rz = rz_next;
+		for (int i = 1; i < nrows-1; i++) {
+			for (int j = 1; j < ncols-1; j++) {
+				CELL(&p, i, j) = CELL(&z, i, j) + beta * CELL(&p, i, j);
+			}
+		}
+	}
+
+	// out of iterations: report the true residual of the answer
+	if (!exact) {
+		compute_residual(plate, &r);
+		res = measure(&r);
+		result->residual = res.max / 4.0;
+		result->residual_l2 = sqrt(res.sum_sq) / 4.0;
+	}
+
+	result->seconds = wall_time() - start;
+	result->tile_cols = 0;
+	result->tile_rows = 0;
+	result->simd = SIMD_SCALAR;
+	result->nthreads = 1;
+
+	grid_free(&r);
+	grid_free(&z);
+	grid_free(&p);
+	grid_free(&q);
+	grid_free(&inv_d);
+	return true;
+}
@@ -0,0 +1,9 @@
+#ifndef CG_H
+#define CG_H
+
+#include "grid.h"
+#include "solver.h"
+
+bool cg_solve(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // CG_H
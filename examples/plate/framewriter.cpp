@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include "framewriter.h"
+#include "gridio.h"
+#include "timer.h"
+
+// File name of the frame for a step, e.g. frame000100.bin
+void frame_name(char *name, size_t size, const char *prefix, long step) {
+	snprintf(name, size, "%s%06li.bin", prefix, step);
+}
+
+// The writer thread: writes full slots in the order they were filled
+// (alternating, starting with slot 0) until told there are no more.
+// The lock is not held while writing, so the simulation can fill the
+// other slot meanwhile.
+static void *writer_main(void *arg) {
+	FrameWriter *w = (FrameWriter *) arg;
+	int k = 0;
+
+	pthread_mutex_lock(&w->lock);
+	for (;;) {
+		while (!w->slots[k].full && !w->done) {
+			pthread_cond_wait(&w->changed, &w->lock);
+		}
+		if (!w->slots[k].full) {
+			break;
+		}
+		FrameSlot *slot = &w->slots[k];
+		bool skip = w->failed;
+		pthread_mutex_unlock(&w->lock);
+
+		// after a failure the frames are dropped, so the simulation
+		// isn't held up, and the failure is reported at the end
+		bool ok = true;
+		double start = wall_time();
+		if (!skip) {
+			char name[FRAME_NAME_MAX];
+			frame_name(name, sizeof(name), w->prefix, slot->step);
+			ok = grid_write(name, &slot->grid, slot->step, slot->residual);
+		}
+		double seconds = wall_time() - start;
+
+		pthread_mutex_lock(&w->lock);
+		if (!skip) {
+			w->write_seconds += seconds;
+			if (ok) {
+				w->frames++;
+			} else {
+				w->failed = true;
+			}
+		}
+		slot->full = false;
+		pthread_cond_broadcast(&w->changed);
+		k = 1 - k;
+	}
+	pthread_mutex_unlock(&w->lock);
+	return NULL;
+}
+
+// Allocate the two nrows by ncols frame buffers and start the writer
+// thread.  Frames are written to PREFIX<step>.bin.
+// Returns false if memory could not be allocated or the thread could
+// not be started.
+bool frame_writer_start(FrameWriter *w, const char *prefix, int nrows, int ncols) {
+	w->prefix = prefix;
+	w->next_slot = 0;
+	w->done = false;
+	w->failed = false;
+	w->frames = 0;
+	w->write_seconds = 0.0;
+	w->wait_seconds = 0.0;
+	w->drain_seconds = 0.0;
+	w->slots[0].full = w->slots[1].full = false;
+
+	if (!grid_alloc(&w->slots[0].grid, nrows, ncols)) {
+		return false;
+	}
+	if (!grid_alloc(&w->slots[1].grid, nrows, ncols)) {
+		grid_free(&w->slots[0].grid);
+		return false;
+	}
+
+	pthread_mutex_init(&w->lock, NULL);
+	pthread_cond_init(&w->changed, NULL);
+	if (pthread_create(&w->thread, NULL, writer_main, w) != 0) {
+		pthread_mutex_destroy(&w->lock);
+		pthread_cond_destroy(&w->changed);
+		grid_free(&w->slots[0].grid);
+		grid_free(&w->slots[1].grid);
+		return false;
+	}
+	return true;
+}
+
+// Hand a copy of g to the writer thread, as the frame for the given
+// step.  This only waits if the writer still has both buffers.
+void frame_writer_submit(FrameWriter *w, const Grid *g, long step, double residual) {
+	FrameSlot *slot = &w->slots[w->next_slot];
+
+	pthread_mutex_lock(&w->lock);
+	if (slot->full) {
+		double start = wall_time();
+		while (slot->full) {
+			pthread_cond_wait(&w->changed, &w->lock);
+		}
+		w->wait_seconds += wall_time() - start;
+	}
+	pthread_mutex_unlock(&w->lock);
+
+	// the writer doesn't touch an empty slot, so it is copied unlocked
+	grid_copy(&slot->grid, g);
+	slot->step = step;
+	slot->residual = residual;
+
+	pthread_mutex_lock(&w->lock);
+	slot->full = true;
+	pthread_cond_broadcast(&w->changed);
+	pthread_mutex_unlock(&w->lock);
+
+	w->next_slot = 1 - w->next_slot;
+}
+
+// Wait for the frames still in the buffers to be written, then stop
+// the writer thread and free the buffers.
+// Returns false (the reason has been printed) if any frame could not
+// be written.
+bool frame_writer_finish(FrameWriter *w) {
+	double start = wall_time();
+
+	pthread_mutex_lock(&w->lock);
+	w->done = true;
+	pthread_cond_broadcast(&w->changed);
+	pthread_mutex_unlock(&w->lock);
+	pthread_join(w->thread, NULL);
+
+	w->drain_seconds = wall_time() - start;
+
+	pthread_mutex_destroy(&w->lock);
+	pthread_cond_destroy(&w->changed);
+	grid_free(&w->slots[0].grid);
+	grid_free(&w->slots[1].grid);
+	return !w->failed;
+}
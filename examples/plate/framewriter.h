@@ -0,0 +1,44 @@
+#ifndef FRAMEWRITER_H
+#define FRAMEWRITER_H
+
+#include <pthread.h>
+#include "grid.h"
+
+// Longest file name a frame can have
+#define FRAME_NAME_MAX 256
+
+// One of the two frame buffers
+struct FrameSlot {
+	Grid grid;
+	long step;
+	double residual;
+	bool full;       // holds a frame the writer hasn't written yet
+};
+
+// Writes snapshots of a running simulation to grid files on a
+// background thread.  The simulation copies each frame into one of two
+// buffers and carries on while the writer thread saves it; it only has
+// to wait if both buffers are still waiting to be written.  The times
+// below say how much of the writing was hidden behind the simulation.
+struct FrameWriter {
+	const char *prefix;          // frames go to PREFIX<step>.bin
+	FrameSlot slots[2];
+	int next_slot;               // slot the next frame is copied into
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	bool done;                   // no more frames are coming
+	bool failed;                 // a frame could not be written
+
+	int frames;                  // frames written
+	double write_seconds;        // time the writer thread spent writing
+	double wait_seconds;         // time the simulation waited for a free buffer
+	double drain_seconds;        // time waiting for the last frames at the end
+};
+
+bool frame_writer_start(FrameWriter *w, const char *prefix, int nrows, int ncols);
+void frame_writer_submit(FrameWriter *w, const Grid *g, long step, double residual);
+bool frame_writer_finish(FrameWriter *w);
+void frame_name(char *name, size_t size, const char *prefix, long step);
+
+#endif // FRAMEWRITER_H
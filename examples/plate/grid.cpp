@@ -0,0 +1,60 @@
+#include <math.h>
+#include <stdio.h>
+#include "grid.h"
+
+// Set the fixed edge temperatures, and set all interior cells to 0
+void grid_init(Grid *g, double left, double right, double top, double bottom) {
+	// Start by initializing all cells to 0
+	for (int i = 0; i < g->nrows; i++) {
+		for (int j = 0; j < g->ncols; j++) {
+			CELL(g, i, j) = 0.0;
+		}
+	}
+
+	// Set temperatures for top and bottom rows
+	for (int j = 0; j < g->ncols; j++) {
+		CELL(g, 0, j) = top;
+		CELL(g, g->nrows-1, j) = bottom;
+	}
+
+	// Set temperatures for left and right columns
+	for (int i = 1; i < g->nrows-1; i++) {
+		CELL(g, i, 0) = left;
+		CELL(g, i, g->ncols-1) = right;
+	}
+}
+
+void grid_print(const Grid *g) {
+	for (int i = 0; i < g->nrows; i++) {
+		for (int j = 0; j < g->ncols; j++) {
+			printf("%6.1lf ", CELL(g, i, j));
+		}
+		printf("\n");
+	}
+}
+
+// Largest absolute value of any cell
+double grid_max_abs(const Grid *g) {
+	size_t n = (size_t) g->nrows * g->ncols;
+	double max = 0.0;
+	for (size_t k = 0; k < n; k++) {
+		if (fabs(g->cells[k]) > max) {
+			max = fabs(g->cells[k]);
+		}
+	}
+	return max;
+}
+
+// Largest absolute difference between matching cells of two grids
+// of the same size
+double grid_max_diff(const Grid *a, const Grid *b) {
+	size_t n = (size_t) a->nrows * a->ncols;
+	double max = 0.0;
+	for (size_t k = 0; k < n; k++) {
+		double diff = fabs(a->cells[k] - b->cells[k]);
+		if (diff > max) {
+			max = diff;
+		}
+	}
+	return max;
+}
@@ -0,0 +1,79 @@
+#ifndef GRID_H
+#define GRID_H
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// A rectangular plate of temperatures.  The cells are stored
+// row by row in one heap-allocated array, so the grid size can
+// be chosen at runtime.  T is the type of one cell; the plate is
+// normally double, but the Jacobi solver can also work in float.
+template <typename T>
+struct GridOf {
+	int nrows;
+	int ncols;
+	T *cells;
+};
+
+typedef GridOf<double> Grid;
+typedef GridOf<float> GridF;
+
+// Cell at row i, column j
+#define CELL(g, i, j) ((g)->cells[(size_t)(i) * (g)->ncols + (j)])
+
+void grid_init(Grid *g, double left, double right, double top, double bottom);
+void grid_print(const Grid *g);
+double grid_max_abs(const Grid *g);
+double grid_max_diff(const Grid *a, const Grid *b);
+
+// Allocate storage for an nrows by ncols grid.
+// Returns false if the memory could not be allocated.
+template <typename T>
+bool grid_alloc(GridOf<T> *g, int nrows, int ncols) {
+	g->nrows = nrows;
+	g->ncols = ncols;
+	g->cells = (T *) malloc((size_t) nrows * ncols * sizeof(T));
+	return g->cells != NULL;
+}
+
+template <typename T>
+void grid_free(GridOf<T> *g) {
+	free(g->cells);
+	g->cells = NULL;
+}
+
+// Set every cell to value
+template <typename T>
+void grid_fill(GridOf<T> *g, T value) {
+	size_t n = (size_t) g->nrows * g->ncols;
+	for (size_t k = 0; k < n; k++) {
+		g->cells[k] = value;
+	}
+}
+
+// Copy all cells of src into dst (which must have the same size)
+template <typename T>
+void grid_copy(GridOf<T> *dst, const GridOf<T> *src) {
+	memcpy(dst->cells, src->cells, (size_t) src->nrows * src->ncols * sizeof(T));
+}
+
+// Copy all cells of src into dst, converting them to dst's cell type
+template <typename D, typename S>
+void grid_convert(GridOf<D> *dst, const GridOf<S> *src) {
+	size_t n = (size_t) src->nrows * src->ncols;
+	for (size_t k = 0; k < n; k++) {
+		dst->cells[k] = (D) src->cells[k];
+	}
+}
+
+// Exchange the cell storage of two grids of the same size.
+// Nothing is copied: only the pointers change places.
+template <typename T>
+void grid_swap(GridOf<T> *a, GridOf<T> *b) {
+	T *tmp = a->cells;
+	a->cells = b->cells;
+	b->cells = tmp;
+}
+
+#endif // GRID_H
@@ -0,0 +1,115 @@
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "gridio.h"
+
+// Write the grid to a file: the header, then all of the cells.
+// The file is sized up front and mapped into memory, so the cells go
+// out in one copy instead of one write (or printf) per cell.
+// Returns false (after printing why) if the file could not be written.
+bool grid_write(const char *filename, const Grid *g, long iteration, double residual) {
+	size_t data_size = (size_t) g->nrows * g->ncols * sizeof(double);
+	size_t file_size = sizeof(GridHeader) + data_size;
+
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(filename);
+		return false;
+	}
+	if (ftruncate(fd, file_size) != 0) {
+		perror(filename);
+		close(fd);
+		return false;
+	}
+
+	void *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		return false;
+	}
+
+	GridHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "PLAT", 4);
+	header.version = GRID_FILE_VERSION;
+	header.nrows = g->nrows;
+	header.ncols = g->ncols;
+	header.dtype = DTYPE_FLOAT64;
+	header.iteration = iteration;
+	header.residual = residual;
+
+	memcpy(map, &header, sizeof(header));
+	memcpy((char *) map + sizeof(header), g->cells, data_size);
+
+	bool ok = munmap(map, file_size) == 0;
+	if (!ok) {
+		perror(filename);
+	}
+	return ok;
+}
+
+// Read a grid written by grid_write, allocating g to the size stored
+// in the file.  iteration and residual are set from the header, so a
+// run can carry on where the file left off.
+// Returns false (after printing why) if the file can't be used.
+bool grid_read(const char *filename, Grid *g, long *iteration, double *residual) {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		perror(filename);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(GridHeader)) {
+		printf("%s: not a grid file\n", filename);
+		close(fd);
+		return false;
+	}
+	size_t file_size = st.st_size;
+
+	void *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		return false;
+	}
+
+	GridHeader header;
+	memcpy(&header, map, sizeof(header));
+
+	// the sizes are checked against INT_MAX (grids are indexed with
+	// ints) and against the file size before anything is allocated, so
+	// a damaged header can't make rows * cols wrap around
+	bool ok = true;
+	size_t cells = (size_t) header.nrows * header.ncols;
+	if (memcmp(header.magic, "PLAT", 4) != 0 || header.version != GRID_FILE_VERSION) {
+		printf("%s: not a grid file\n", filename);
+		ok = false;
+	} else if (header.dtype != DTYPE_FLOAT64) {
+		printf("%s: unknown element type %u\n", filename, header.dtype);
+		ok = false;
+	} else if (header.nrows < 3 || header.ncols < 3 || header.nrows > INT_MAX
+			|| header.ncols > INT_MAX
+			|| cells != (file_size - sizeof(GridHeader)) / sizeof(double)
+			|| (file_size - sizeof(GridHeader)) % sizeof(double) != 0) {
+		printf("%s: grid size doesn't match file size\n", filename);
+		ok = false;
+	} else if (!grid_alloc(g, (int) header.nrows, (int) header.ncols)) {
+		printf("Not enough memory for a %ux%u plate\n", header.nrows, header.ncols);
+		ok = false;
+	}
+
+	if (ok) {
+		memcpy(g->cells, (const char *) map + sizeof(header), cells * sizeof(double));
+		*iteration = header.iteration;
+		*residual = header.residual;
+	}
+
+	munmap(map, file_size);
+	return ok;
+}
@@ -0,0 +1,32 @@
+#ifndef GRIDIO_H
+#define GRIDIO_H
+
+#include <stdint.h>
+#include "grid.h"
+
+// Element types a grid file can hold
+enum GridDtype {
+	DTYPE_FLOAT64 = 1
+};
+
+// Header at the start of a grid file.  The cells follow it directly,
+// row by row, in the machine's byte order.  It is 64 bytes long, so
+// the cells start on a cache line boundary when the file is mapped.
+struct GridHeader {
+	char magic[4];        // "PLAT"
+	uint32_t version;     // GRID_FILE_VERSION
+	uint32_t nrows;
+	uint32_t ncols;
+	uint32_t dtype;       // a GridDtype
+	uint32_t reserved;
+	int64_t iteration;    // sweeps done so far
+	double residual;      // residual after the last sweep
+	char pad[24];
+};
+
+#define GRID_FILE_VERSION 1
+
+bool grid_write(const char *filename, const Grid *g, long iteration, double residual);
+bool grid_read(const char *filename, Grid *g, long *iteration, double *residual);
+
+#endif // GRIDIO_H
@@ -0,0 +1,337 @@
+#include <float.h>
+#include <math.h>
+#include "jacobi.h"
+#include "parallel.h"
+#include "stencil.h"
+#include "temporal.h"
+#include "timer.h"
+
+// number of sweeps timed for each candidate tile width when autotuning
+#define TUNE_SWEEPS 3
+
+// In mixed precision, switch from float to double once the residual
+// is this small relative to the hottest cell: float sweeps can't make
+// much more progress than that before rounding gets in the way.
+#define MIXED_SWITCH (100 * FLT_EPSILON)
+
+// Compute new temperatures for the interior of the plate:
+// each interior cell becomes the average of its top/bottom/left/right
+// neighbors.  The edge cells of next are not touched, so they must
+// already hold the fixed edge temperatures.  update does the work for
+// each row (see row_update).
+// Unless res is NULL, it is set to the residual of the sweep (how much
+// the cells changed), measured along the way rather than in a second
+// pass over both grids.
+template <typename T>
+void jacobi_sweep(const GridOf<T> *cur, GridOf<T> *next, typename RowKernel<T>::Update update,
+		ResidualOf<T> *res) {
+	if (res != NULL) {
+		res->max = 0;
+		res->sum_sq = 0;
+	}
+
+	for (int i = 1; i < cur->nrows-1; i++) {
+		update(&CELL(cur, i-1, 0), &CELL(cur, i, 0), &CELL(cur, i+1, 0),
+			&CELL(next, i, 0), 1, cur->ncols-1, res);
+	}
+}
+
+// Same as jacobi_sweep, but the interior is processed in vertical
+// strips that are tile_cols cells wide.  Each strip is walked from top
+// to bottom, so the three rows being read are only tile_cols wide and
+// stay in cache, instead of three full rows that may not fit once the
+// plate is large.  The result is identical to jacobi_sweep.
+template <typename T>
+void jacobi_sweep_tiled(const GridOf<T> *cur, GridOf<T> *next, int tile_cols,
+		typename RowKernel<T>::Update update, ResidualOf<T> *res) {
+	jacobi_sweep_rows(cur, next, 1, cur->nrows-1, tile_cols, update, res);
+}
+
+// Tiled sweep of interior rows row_begin..row_end-1 only.  This is
+// the part of a sweep done by one thread of the parallel solver.
+template <typename T>
+void jacobi_sweep_rows(const GridOf<T> *cur, GridOf<T> *next, int row_begin, int row_end,
+		int tile_cols, typename RowKernel<T>::Update update, ResidualOf<T> *res) {
+	if (tile_cols <= 0 || tile_cols >= cur->ncols-2) {
+		tile_cols = cur->ncols-2;
+	}
+
+	if (res != NULL) {
+		res->max = 0;
+		res->sum_sq = 0;
+	}
+
+	for (int jj = 1; jj < cur->ncols-1; jj += tile_cols) {
+		int jend = jj + tile_cols;
+		if (jend > cur->ncols-1) {
+			jend = cur->ncols-1;
+		}
+
+		for (int i = row_begin; i < row_end; i++) {
+			update(&CELL(cur, i-1, 0), &CELL(cur, i, 0), &CELL(cur, i+1, 0),
+				&CELL(next, i, 0), jj, jend, res);
+		}
+	}
+}
+
+// Sweep only the interior cells listed in spans[0..nspans-1] (see
+// Mask).  Each span is one call of the row update, so the cells
+// between spans are skipped without being looked at.  Every other
+// cell of next is left alone, so next must already hold the fixed
+// temperatures.
+template <typename T>
+void jacobi_sweep_spans(const GridOf<T> *cur, GridOf<T> *next, const Span *spans, int nspans,
+		typename RowKernel<T>::Update update, ResidualOf<T> *res) {
+	if (res != NULL) {
+		res->max = 0;
+		res->sum_sq = 0;
+	}
+
+	for (int k = 0; k < nspans; k++) {
+		int i = spans[k].row;
+		update(&CELL(cur, i-1, 0), &CELL(cur, i, 0), &CELL(cur, i+1, 0),
+			&CELL(next, i, 0), spans[k].jbegin, spans[k].jend, res);
+	}
+}
+
+// Time a few sweeps of cur into next with the given tile width
+template <typename T>
+static double time_sweeps(const GridOf<T> *cur, GridOf<T> *next, int tile_cols,
+		typename RowKernel<T>::Update update) {
+	ResidualOf<T> res;
+	double start = wall_time();
+	for (int k = 0; k < TUNE_SWEEPS; k++) {
+		jacobi_sweep_tiled(cur, next, tile_cols, update, &res);
+	}
+	return wall_time() - start;
+}
+
+// Pick the fastest tile width for this plate by timing a few sweeps
+// untiled and with each power of two width from 64 up to the plate
+// width.  Only next is written, so cur is left unchanged.
+// Returns 0 if untiled sweeps are fastest.
+template <typename T>
+int jacobi_autotune(const GridOf<T> *cur, GridOf<T> *next, typename RowKernel<T>::Update update) {
+	int best_width = 0;
+	double best_time = time_sweeps(cur, next, 0, update);
+
+	for (int width = 64; width < cur->ncols-2; width *= 2) {
+		double elapsed = time_sweeps(cur, next, width, update);
+		if (elapsed < best_time) {
+			best_width = width;
+			best_time = elapsed;
+		}
+	}
+
+	return best_width;
+}
+
+template void jacobi_sweep(const GridF *, GridF *, RowUpdateF, ResidualF *);
+template void jacobi_sweep(const Grid *, Grid *, RowUpdate, Residual *);
+template void jacobi_sweep_tiled(const GridF *, GridF *, int, RowUpdateF, ResidualF *);
+template void jacobi_sweep_tiled(const Grid *, Grid *, int, RowUpdate, Residual *);
+template void jacobi_sweep_rows(const GridF *, GridF *, int, int, int, RowUpdateF, ResidualF *);
+template void jacobi_sweep_rows(const Grid *, Grid *, int, int, int, RowUpdate, Residual *);
+template void jacobi_sweep_spans(const GridF *, GridF *, const Span *, int, RowUpdateF, ResidualF *);
+template void jacobi_sweep_spans(const Grid *, Grid *, const Span *, int, RowUpdate, Residual *);
+template int jacobi_autotune(const GridF *, GridF *, RowUpdateF);
+template int jacobi_autotune(const Grid *, Grid *, RowUpdate);
+
+// Whether the residual should be measured on the sweep(s) taking the
+// sweep count from done to after: only when that passes a multiple of
+// check_every, so the reduction can be skipped on most sweeps, and
+// always on the last sweep allowed, so the final residual is known.
+bool jacobi_check_due(long done, long after, long max_iter, int check_every) {
+	if (check_every <= 1 || after >= max_iter) {
+		return true;
+	}
+	return after / check_every > done / check_every;
+}
+
+// Repeat Jacobi sweeps on the plate until the residual meets
+// params->tol (or its largest change is at most switch_tol), or
+// max_iter sweeps have been done.  The residual is only measured
+// every params->check_every sweeps, and each measurement is passed
+// on to params->monitor.
+// A second buffer is allocated once, and the two buffers trade places
+// after every sweep, so the grid is never copied back.  When done,
+// plate holds the final temperatures.
+// With params->time_steps > 1, that many sweeps at a time are done
+// with temporal blocking, and the residual is only checked after each
+// group of sweeps.  With params->mask, only the masked cells are swept,
+// without tiles.
+// Returns false if the second buffer could not be allocated.
+template <typename T>
+static bool jacobi_iterate(GridOf<T> *plate, const SolveParams *params, double switch_tol,
+		long max_iter, SolveResult *result) {
+	GridOf<T> next;
+	if (!grid_alloc(&next, plate->nrows, plate->ncols)) {
+		return false;
+	}
+
+	// the edge cells never change, so copy them (and everything
+	// else) into the second buffer once
+	grid_copy(&next, plate);
+
+	result->simd = simd_resolve(params->simd);
+	typename RowKernel<T>::Update update = row_update<T>(result->simd);
+
+	const Mask *mask = params->mask;
+	bool temporal = params->time_steps > 1 && mask == NULL;
+	int tile_rows = params->tile_rows > 0 ? params->tile_rows : TEMPORAL_TILE_ROWS;
+	int tile_cols = params->tile_cols;
+	if (mask != NULL) {
+		tile_cols = 0;
+	} else if (temporal && tile_cols <= 0) {
+		tile_cols = TEMPORAL_TILE_COLS;
+	} else if (tile_cols == TILE_AUTO) {
+		tile_cols = jacobi_autotune(plate, &next, update);
+	}
+	result->tile_cols = tile_cols;
+	result->tile_rows = temporal ? tile_rows : 0;
+	result->nthreads = 1;
+
+	double start = wall_time();
+
+	result->iterations = 0;
+	result->residual = 0.0;
+	result->residual_l2 = 0.0;
+	while (result->iterations < max_iter) {
+		long done = result->iterations;
+		int steps = temporal ? params->time_steps : 1;
+		if (steps > max_iter - done) {
+			steps = max_iter - done;
+		}
+		result->iterations += steps;
+
+		ResidualOf<T> res;
+		bool check = jacobi_check_due(done, result->iterations, max_iter, params->check_every);
+
+		if (temporal) {
+			jacobi_sweeps_temporal(plate, &next, steps, tile_rows, tile_cols, update,
+				check ? &res : NULL);
+
+			// after an odd number of sweeps the newest temperatures are in next
+			if (steps % 2 == 1) {
+				grid_swap(plate, &next);
+			}
+		} else {
+			if (mask != NULL) {
+				jacobi_sweep_spans(plate, &next, mask->spans, mask->nspans, update,
+					check ? &res : NULL);
+			} else {
+				jacobi_sweep_tiled(plate, &next, tile_cols, update, check ? &res : NULL);
+			}
+
+			// the new temperatures become the current temperatures
+			grid_swap(plate, &next);
+		}
+
+		if (check) {
+			result->residual = res.max;
+			result->residual_l2 = sqrt((double) res.sum_sq);
+			if (params->monitor != NULL) {
+				params->monitor(result->iterations, result->residual, result->residual_l2,
+					params->monitor_arg);
+			}
+			if (residual_converged(params, result->residual, result->residual_l2)
+					|| result->residual <= switch_tol) {
+				break;
+			}
+		}
+	}
+
+	result->seconds = wall_time() - start;
+
+	grid_free(&next);
+	return true;
+}
+
+// Solve the plate in double precision, with threads if asked for
+static bool jacobi_solve_double(Grid *plate, const SolveParams *params, long max_iter,
+		SolveResult *result) {
+	if (params->nthreads > 1) {
+		SolveParams capped = *params;
+		capped.max_iter = max_iter;
+		return jacobi_solve_parallel(plate, &capped, result);
+	}
+	return jacobi_iterate(plate, params, -1.0, max_iter, result);
+}
+
+// Passes residuals on to another monitor, with the sweep counts moved
+// up by offset.  Used for the double sweeps of mixed precision, which
+// count from 0 again.
+struct OffsetMonitor {
+	ResidualMonitor monitor;
+	void *arg;
+	long offset;
+};
+
+static void offset_monitor(long iteration, double max_change, double l2, void *arg) {
+	OffsetMonitor *om = (OffsetMonitor *) arg;
+	om->monitor(om->offset + iteration, max_change, l2, om->arg);
+}
+
+// Repeat Jacobi sweeps on the plate until the residual (in the norm
+// params->norm) is at most params->tol, or params->max_iter sweeps
+// have been done.
+//
+// params->precision picks the type the sweeps are done in.  In float,
+// each sweep moves half as many bytes as in double, but the answer is
+// only as accurate as float allows.  In mixed precision, float sweeps
+// are done until the residual gets close to what float can resolve,
+// then double sweeps finish the job to the full tolerance.  Either
+// way the plate (double) holds the final temperatures.  The float
+// sweeps always use one thread.
+// Returns false if memory could not be allocated.
+bool jacobi_solve(Grid *plate, const SolveParams *params, SolveResult *result) {
+	result->float_iterations = 0;
+
+	if (params->precision == PRECISION_DOUBLE) {
+		return jacobi_solve_double(plate, params, params->max_iter, result);
+	}
+
+	double start = wall_time();
+
+	GridF single;
+	if (!grid_alloc(&single, plate->nrows, plate->ncols)) {
+		return false;
+	}
+	grid_convert(&single, plate);
+
+	double switch_tol = -1.0;
+	if (params->precision == PRECISION_MIXED) {
+		switch_tol = MIXED_SWITCH * grid_max_abs(plate);
+	}
+
+	bool ok = jacobi_iterate(&single, params, switch_tol, params->max_iter, result);
+	if (ok) {
+		grid_convert(plate, &single);
+	}
+	grid_free(&single);
+	result->float_iterations = result->iterations;
+
+	if (ok && params->precision == PRECISION_MIXED
+			&& !residual_converged(params, result->residual, result->residual_l2)
+			&& result->iterations < params->max_iter) {
+		// finish in double
+		SolveParams refine_params = *params;
+		OffsetMonitor om = { params->monitor, params->monitor_arg, result->iterations };
+		if (params->monitor != NULL) {
+			refine_params.monitor = offset_monitor;
+			refine_params.monitor_arg = &om;
+		}
+
+		SolveResult refine;
+		ok = jacobi_solve_double(plate, &refine_params, params->max_iter - result->iterations,
+			&refine);
+		if (ok) {
+			refine.iterations += result->iterations;
+			refine.float_iterations = result->float_iterations;
+			*result = refine;
+		}
+	}
+
+	result->seconds = wall_time() - start;
+	return ok;
+}
@@ -0,0 +1,33 @@
+#ifndef JACOBI_H
+#define JACOBI_H
+
+#include "grid.h"
+#include "mask.h"
+#include "solver.h"
+#include "stencil.h"
+
+// The sweeps work on grids of double or float cells (T)
+
+template <typename T>
+void jacobi_sweep(const GridOf<T> *cur, GridOf<T> *next, typename RowKernel<T>::Update update,
+	ResidualOf<T> *res);
+
+template <typename T>
+void jacobi_sweep_tiled(const GridOf<T> *cur, GridOf<T> *next, int tile_cols,
+	typename RowKernel<T>::Update update, ResidualOf<T> *res);
+
+template <typename T>
+void jacobi_sweep_rows(const GridOf<T> *cur, GridOf<T> *next, int row_begin, int row_end,
+	int tile_cols, typename RowKernel<T>::Update update, ResidualOf<T> *res);
+
+template <typename T>
+void jacobi_sweep_spans(const GridOf<T> *cur, GridOf<T> *next, const Span *spans, int nspans,
+	typename RowKernel<T>::Update update, ResidualOf<T> *res);
+
+template <typename T>
+int jacobi_autotune(const GridOf<T> *cur, GridOf<T> *next, typename RowKernel<T>::Update update);
+
+bool jacobi_check_due(long done, long after, long max_iter, int check_every);
+bool jacobi_solve(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // JACOBI_H
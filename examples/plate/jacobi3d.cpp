@@ -0,0 +1,174 @@
+#include "bands.h"
+#include "jacobi3d.h"
+
+// Cache space the 2.5D tiles are sized to fit in (a good part of a
+// typical L2 cache)
+#define BLOCK_CACHE_BYTES (512 * 1024)
+
+// Compute new temperatures for layers z_begin..z_end-1 of the interior
+// of the block: each interior cell becomes the average of its six
+// neighbors.  The face cells of next are not touched, so they must
+// already hold the fixed face temperatures.
+//
+// Updating layer z reads layers z-1, z and z+1, so a plain sweep, layer
+// by layer, only reads each cell from memory once if three whole layers
+// stay in cache; a 512x512 layer is 2 MB, so on big blocks most cells
+// are fetched three times.  With 2.5D blocking, the x-y plane is cut
+// into tiles of tile_rows by tile_cols cells, and each tile is swept
+// through all of the layers before going on to the next tile.  Then
+// only three layers of one tile need to stay in cache.  The result is
+// identical to the plain sweep.  tile_cols = 0 means whole rows and
+// tile_rows = 0 whole layers (so both 0 is a plain sweep).
+//
+// Unless res is NULL, it is set to the residual of the sweep.
+void jacobi3d_sweep(const Volume *cur, Volume *next, int z_begin, int z_end,
+		int tile_cols, int tile_rows, RowUpdate7 update, Residual *res) {
+	if (tile_cols <= 0 || tile_cols > cur->nx-2) {
+		tile_cols = cur->nx-2;
+	}
+	if (tile_rows <= 0 || tile_rows > cur->ny-2) {
+		tile_rows = cur->ny-2;
+	}
+
+	if (res != NULL) {
+		res->max = 0.0;
+		res->sum_sq = 0.0;
+	}
+
+	for (int yy = 1; yy < cur->ny-1; yy += tile_rows) {
+		int yend = yy + tile_rows;
+		if (yend > cur->ny-1) {
+			yend = cur->ny-1;
+		}
+
+		for (int xx = 1; xx < cur->nx-1; xx += tile_cols) {
+			int xend = xx + tile_cols;
+			if (xend > cur->nx-1) {
+				xend = cur->nx-1;
+			}
+
+			for (int z = z_begin; z < z_end; z++) {
+				for (int y = yy; y < yend; y++) {
+					update(&VCELL(cur, 0, y, z-1), &VCELL(cur, 0, y-1, z), &VCELL(cur, 0, y, z),
+						&VCELL(cur, 0, y+1, z), &VCELL(cur, 0, y, z+1), &VCELL(next, 0, y, z),
+						xx, xend, res);
+				}
+			}
+		}
+	}
+}
+
+// Number of rows per 2.5D tile for a block, if the tiles are tile_cols
+// wide (0 = whole rows): as many as fit in BLOCK_CACHE_BYTES with three
+// layers of the tile being read and one written.
+int jacobi3d_auto_rows(const Volume *v, int tile_cols) {
+	int width = (tile_cols > 0 && tile_cols < v->nx) ? tile_cols + 2 : v->nx;
+	int rows = BLOCK_CACHE_BYTES / (4 * width * (int) sizeof(double)) - 2;
+	if (rows < 1) {
+		rows = 1;
+	}
+	if (rows >= v->ny-2) {
+		rows = 0;
+	}
+	return rows;
+}
+
+// The block being solved, and how it is split into slabs
+struct Block {
+	Volume volume[2];  // the block and the second buffer
+	RowUpdate7 update;
+	int tile_cols;
+	int tile_rows;
+	int nthreads;
+};
+
+// Layers z_begin..z_end-1 of the interior, updated by thread k
+static int slab_begin(const Block *b, int k) {
+	return 1 + (long) (b->volume[0].nz - 2) * k / b->nthreads;
+}
+
+static int slab_end(const Block *b, int k) {
+	return slab_begin(b, k+1);
+}
+
+// First touch of our own layers of the second buffer
+static void slab_start(void *arg, int k) {
+	Block *b = (Block *) arg;
+	const Volume *cur = &b->volume[0];
+	size_t layer = (size_t) cur->nx * cur->ny;
+	for (int z = slab_begin(b, k); z < slab_end(b, k); z++) {
+		for (size_t c = 0; c < layer; c++) {
+			b->volume[1].cells[z * layer + c] = cur->cells[z * layer + c];
+		}
+	}
+}
+
+// Each thread sweeps its own slab of layers, in 2.5D tiles, just as
+// the 2D solver gives each thread a band of rows (see bands.cpp).
+static void slab_sweep(void *arg, int k, int from, Residual *res) {
+	Block *b = (Block *) arg;
+	jacobi3d_sweep(&b->volume[from], &b->volume[1-from], slab_begin(b, k), slab_end(b, k),
+		b->tile_cols, b->tile_rows, b->update, res);
+}
+
+// Repeat Jacobi sweeps on the block until the residual (in the norm
+// params->norm) is at most params->tol, or params->max_iter sweeps
+// have been done, measuring it every params->check_every sweeps.
+// The sweeps use 2.5D tiles params->tile_rows by params->tile_cols
+// (TILE_AUTO rows = sized to fit in cache), and are shared by
+// params->nthreads threads, each taking a slab of layers.  When done,
+// block holds the final temperatures.
+// Returns false if memory could not be allocated or the threads could
+// not be started.
+bool jacobi3d_solve(Volume *block, const SolveParams *params, SolveResult *result) {
+	int interior = block->nz - 2;
+	int nthreads = params->nthreads;
+	if (nthreads > interior) {
+		nthreads = interior;
+	}
+
+	Block b;
+	b.volume[0] = *block;
+	b.nthreads = nthreads;
+	b.update = row_update7(params->simd);
+	b.tile_cols = params->tile_cols > 0 ? params->tile_cols : 0;
+	b.tile_rows = params->tile_rows;
+	if (b.tile_rows == TILE_AUTO) {
+		b.tile_rows = jacobi3d_auto_rows(block, b.tile_cols);
+	}
+
+	Volume *next = &b.volume[1];
+	if (!volume_alloc(next, block->nx, block->ny, block->nz)) {
+		return false;
+	}
+
+	// the bottom and top layers are copied here, the rest by the owning thread
+	size_t layer = (size_t) block->nx * block->ny;
+	for (size_t k = 0; k < layer; k++) {
+		next->cells[k] = block->cells[k];
+		next->cells[(block->nz-1) * layer + k] = block->cells[(block->nz-1) * layer + k];
+	}
+
+	BandSweeps sweeps;
+	sweeps.nthreads = nthreads;
+	sweeps.start = slab_start;
+	sweeps.sweep = slab_sweep;
+	sweeps.arg = &b;
+	bool ok = bands_solve(&sweeps, params, result);
+
+	if (ok) {
+		result->tile_cols = b.tile_cols;
+		result->tile_rows = b.tile_rows;
+		result->simd = simd_resolve(params->simd);
+		result->omega = 0.0;
+		result->float_iterations = 0;
+
+		// after an odd number of sweeps the answer is in the second buffer
+		if (result->iterations % 2 == 1) {
+			volume_swap(block, next);
+		}
+	}
+
+	volume_free(next);
+	return ok;
+}
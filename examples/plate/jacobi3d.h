@@ -0,0 +1,13 @@
+#ifndef JACOBI3D_H
+#define JACOBI3D_H
+
+#include "solver.h"
+#include "stencil.h"
+#include "volume.h"
+
+void jacobi3d_sweep(const Volume *cur, Volume *next, int z_begin, int z_end,
+	int tile_cols, int tile_rows, RowUpdate7 update, Residual *res);
+int jacobi3d_auto_rows(const Volume *v, int tile_cols);
+bool jacobi3d_solve(Volume *block, const SolveParams *params, SolveResult *result);
+
+#endif // JACOBI3D_H
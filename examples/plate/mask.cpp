@@ -0,0 +1,197 @@
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "mask.h"
+
+// largest width or height accepted from an image file
+#define MAX_IMAGE_SIZE 100000
+
+// Find the runs of interior cells in interior[] (nrows by ncols, row
+// by row) and store them in mask.  The outer ring is skipped, since
+// edge cells have no neighbors on one side.
+// Returns false if the spans could not be allocated.
+bool mask_build(Mask *mask, const bool *interior, int nrows, int ncols) {
+	mask->nrows = nrows;
+	mask->ncols = ncols;
+	mask->nspans = 0;
+	mask->ncells = 0;
+
+	// first count the spans, then fill them in
+	for (int pass = 0; pass < 2; pass++) {
+		int n = 0;
+		for (int i = 1; i < nrows-1; i++) {
+			const bool *row = &interior[(size_t) i * ncols];
+			int j = 1;
+			while (j < ncols-1) {
+				if (!row[j]) {
+					j++;
+					continue;
+				}
+				int jbegin = j;
+				while (j < ncols-1 && row[j]) {
+					j++;
+				}
+				if (pass == 1) {
+					mask->spans[n].row = i;
+					mask->spans[n].jbegin = jbegin;
+					mask->spans[n].jend = j;
+					mask->ncells += j - jbegin;
+				}
+				n++;
+			}
+		}
+
+		if (pass == 0) {
+			mask->nspans = n;
+			mask->spans = (Span *) malloc((n > 0 ? n : 1) * sizeof(Span));
+			if (mask->spans == NULL) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+void mask_free(Mask *mask) {
+	free(mask->spans);
+	mask->spans = NULL;
+	mask->nspans = 0;
+}
+
+// Read the next number from a PGM header, skipping white space and
+// "#" comments.  The one white space character after the number is
+// read too, so after the last header number the file is positioned at
+// the pixels.
+// Returns false if there is no number.
+static bool pgm_number(FILE *f, int *value) {
+	int c = fgetc(f);
+	while (c == '#' || isspace(c)) {
+		if (c == '#') {
+			while (c != EOF && c != '\n') {
+				c = fgetc(f);
+			}
+		}
+		c = fgetc(f);
+	}
+	if (!isdigit(c)) {
+		return false;
+	}
+
+	long n = 0;
+	while (isdigit(c)) {
+		n = n * 10 + (c - '0');
+		if (n > MAX_IMAGE_SIZE) {
+			return false;
+		}
+		c = fgetc(f);
+	}
+	*value = n;
+	return true;
+}
+
+// Read the pixels of a PGM image (binary "P5" or text "P2") into a
+// newly allocated array, row by row.
+// Returns NULL (after printing why) if the file can't be read.
+static unsigned short *pgm_read(const char *filename, int *nrows, int *ncols, int *maxval) {
+	FILE *f = fopen(filename, "rb");
+	if (f == NULL) {
+		perror(filename);
+		return NULL;
+	}
+
+	char magic[2];
+	int width, height;
+	if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' || (magic[1] != '2' && magic[1] != '5')
+			|| !pgm_number(f, &width) || !pgm_number(f, &height) || !pgm_number(f, maxval)
+			|| *maxval < 1 || *maxval > 65535) {
+		printf("%s: not a PGM image\n", filename);
+		fclose(f);
+		return NULL;
+	}
+	if (width < 3 || height < 3) {
+		printf("%s: a plate needs at least 3x3 cells\n", filename);
+		fclose(f);
+		return NULL;
+	}
+
+	size_t npixels = (size_t) width * height;
+	unsigned short *pixels = (unsigned short *) malloc(npixels * sizeof(unsigned short));
+	if (pixels == NULL) {
+		printf("Not enough memory for a %ix%i plate\n", height, width);
+		fclose(f);
+		return NULL;
+	}
+
+	bool ok = true;
+	for (size_t k = 0; k < npixels && ok; k++) {
+		int value;
+		if (magic[1] == '2') {
+			ok = fscanf(f, "%d", &value) == 1;
+		} else if (*maxval < 256) {
+			value = fgetc(f);
+			ok = value != EOF;
+		} else {
+			// 16-bit pixels are stored most significant byte first
+			int hi = fgetc(f);
+			int lo = fgetc(f);
+			ok = lo != EOF;
+			value = (hi << 8) | lo;
+		}
+		ok = ok && value >= 0 && value <= *maxval;
+		if (ok) {
+			pixels[k] = value;
+		}
+	}
+	fclose(f);
+
+	if (!ok) {
+		printf("%s: image is cut short or has bad pixels\n", filename);
+		free(pixels);
+		return NULL;
+	}
+
+	*nrows = height;
+	*ncols = width;
+	return pixels;
+}
+
+// Read the shape of a plate from a PGM image, one pixel per cell.
+// White pixels (the image's maximum value) are interior cells, to be
+// solved for.  Every other pixel is a cell held at a fixed temperature
+// equal to its gray level: black is 0 degrees, and in an 8-bit image
+// 254 is the hottest a fixed cell can be.  White pixels in the outer
+// ring can't be solved for, and are held at 0.
+// plate is allocated to the size of the image and filled with the
+// fixed temperatures, with the interior cells starting at 0.
+// Returns false (after printing why) if the image can't be used.
+bool mask_read(const char *filename, Mask *mask, Grid *plate) {
+	int nrows, ncols, maxval;
+	unsigned short *pixels = pgm_read(filename, &nrows, &ncols, &maxval);
+	if (pixels == NULL) {
+		return false;
+	}
+
+	size_t npixels = (size_t) nrows * ncols;
+	bool *interior = (bool *) malloc(npixels * sizeof(bool));
+	if (interior == NULL || !grid_alloc(plate, nrows, ncols)) {
+		printf("Not enough memory for a %ix%i plate\n", nrows, ncols);
+		free(interior);
+		free(pixels);
+		return false;
+	}
+
+	for (size_t k = 0; k < npixels; k++) {
+		interior[k] = pixels[k] == maxval;
+		plate->cells[k] = interior[k] ? 0.0 : pixels[k];
+	}
+	free(pixels);
+
+	bool ok = mask_build(mask, interior, nrows, ncols);
+	free(interior);
+	if (!ok) {
+		printf("Not enough memory for a %ix%i plate\n", nrows, ncols);
+		grid_free(plate);
+	}
+	return ok;
+}
@@ -0,0 +1,31 @@
+#ifndef MASK_H
+#define MASK_H
+
+#include "grid.h"
+
+// A run of interior cells in one row: columns jbegin..jend-1 of row
+struct Span {
+	int row;
+	int jbegin;
+	int jend;
+};
+
+// The cells of a plate that are solved for, when the part isn't a
+// plain rectangle.  They are stored as runs of neighboring interior
+// cells, row by row from the top, so a sweep goes straight from one
+// run to the next: holes, notches and cells held at a fixed
+// temperature cost nothing, and no cell is tested on every sweep.
+// Cells in the outer ring of the plate are never interior.
+struct Mask {
+	int nrows;
+	int ncols;
+	Span *spans;
+	int nspans;
+	long ncells;      // number of interior cells in all of the spans
+};
+
+bool mask_build(Mask *mask, const bool *interior, int nrows, int ncols);
+bool mask_read(const char *filename, Mask *mask, Grid *plate);
+void mask_free(Mask *mask);
+
+#endif // MASK_H
@@ -0,0 +1,252 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "multigrid.h"
+#include "sor.h"
+#include "stencil.h"
+#include "timer.h"
+
+// smoothing sweeps before and after visiting the coarser grid
+#define PRE_SMOOTH 2
+#define POST_SMOOTH 2
+
+// One level of the grid hierarchy.  Level 0 is the plate itself;
+// each coarser level keeps every other row and column of the one
+// before it, so its cells are twice as far apart.
+//
+// On every level we solve the same kind of equation,
+//   (4*u[i][j] - (sum of the 4 neighbors of u[i][j])) / h^2 = f[i][j]
+// On the plate f is 0 (each cell is the average of its neighbors);
+// on coarser levels u is a correction to the level above and f is
+// that level's leftover error (residual), carried down.
+struct Level {
+	Grid u;       // temperatures (level 0) or corrections
+	Grid f;       // right-hand side
+	Grid r;       // residual f - A u
+	double h2;    // square of the cell spacing
+};
+
+static bool is_power_of_two(int n) {
+	return n > 0 && (n & (n - 1)) == 0;
+}
+
+// Red-black relaxation of u toward the solution of A u = f:
+// each cell becomes the average of its neighbors plus h^2 f / 4,
+// which is the plate's usual 4-neighbor average when f is 0.
+static void smooth(Level *lev, double omega, int sweeps) {
+	Grid *u = &lev->u;
+	Grid *f = &lev->f;
+
+	for (int k = 0; k < sweeps; k++) {
+		for (int color = 0; color < 2; color++) {
+			for (int i = 1; i < u->nrows-1; i++) {
+				int jstart = ((i + 1) % 2 == color) ? 1 : 2;
+				for (int j = jstart; j < u->ncols-1; j += 2) {
+					double sum_neighbors = CELL(u, i-1, j) + CELL(u, i+1, j)
+						+ CELL(u, i, j-1) + CELL(u, i, j+1);
+					double avg = (sum_neighbors + lev->h2 * CELL(f, i, j)) / 4.0;
+					CELL(u, i, j) += omega * (avg - CELL(u, i, j));
+				}
+			}
+		}
+	}
+}
+
+// r = f - A u on the interior.
+// Returns the largest |r| and the sum of the r^2.
+static Residual compute_residual(Level *lev) {
+	Grid *u = &lev->u;
+	Residual res = { 0.0, 0.0 };
+
+	for (int i = 1; i < u->nrows-1; i++) {
+		for (int j = 1; j < u->ncols-1; j++) {
+			double sum_neighbors = CELL(u, i-1, j) + CELL(u, i+1, j)
+				+ CELL(u, i, j-1) + CELL(u, i, j+1);
+			double r = CELL(&lev->f, i, j) - (4.0 * CELL(u, i, j) - sum_neighbors) / lev->h2;
+			CELL(&lev->r, i, j) = r;
+			if (fabs(r) > res.max) {
+				res.max = fabs(r);
+			}
+			res.sum_sq += r * r;
+		}
+	}
+
+	return res;
+}
+
+// Full-weighting restriction of the fine residual to the coarse
+// right-hand side: each coarse cell gets a 1-2-1 weighted average of
+// the 3x3 block of fine cells around it.
+static void restrict_residual(const Level *fine, Level *coarse) {
+	const Grid *r = &fine->r;
+
+	for (int i = 1; i < coarse->f.nrows-1; i++) {
+		for (int j = 1; j < coarse->f.ncols-1; j++) {
+			int fi = 2*i, fj = 2*j;
+			double center = CELL(r, fi, fj);
+			double edges = CELL(r, fi-1, fj) + CELL(r, fi+1, fj)
+				+ CELL(r, fi, fj-1) + CELL(r, fi, fj+1);
+			double corners = CELL(r, fi-1, fj-1) + CELL(r, fi-1, fj+1)
+				+ CELL(r, fi+1, fj-1) + CELL(r, fi+1, fj+1);
+			CELL(&coarse->f, i, j) = (4.0 * center + 2.0 * edges + corners) / 16.0;
+		}
+	}
+}
+
+// Bilinear interpolation of the coarse correction, added to the fine
+// level.  Fine cells that line up with a coarse cell get its value,
+// cells between two coarse cells get the average of both, and cells
+// between four get the average of all four.  The coarse edges are 0,
+// so the fixed edges of the plate are left alone.
+static void prolong_correction(const Level *coarse, Level *fine) {
+	const Grid *e = &coarse->u;
+	Grid *u = &fine->u;
+
+	for (int i = 1; i < u->nrows-1; i++) {
+		int ci = i / 2;
+		for (int j = 1; j < u->ncols-1; j++) {
+			int cj = j / 2;
+			double correction;
+			if (i % 2 == 0 && j % 2 == 0) {
+				correction = CELL(e, ci, cj);
+			} else if (i % 2 == 0) {
+				correction = (CELL(e, ci, cj) + CELL(e, ci, cj+1)) / 2.0;
+			} else if (j % 2 == 0) {
+				correction = (CELL(e, ci, cj) + CELL(e, ci+1, cj)) / 2.0;
+			} else {
+				correction = (CELL(e, ci, cj) + CELL(e, ci, cj+1)
+					+ CELL(e, ci+1, cj) + CELL(e, ci+1, cj+1)) / 4.0;
+			}
+			CELL(u, i, j) += correction;
+		}
+	}
+}
+
+// One V-cycle starting at level l: smooth, hand the leftover error to
+// the next coarser level, solve there (recursively), add the
+// correction back, and smooth again.
+static void vcycle(Level *levels, int l, int nlevels) {
+	Level *lev = &levels[l];
+
+	if (l == nlevels-1) {
+		// The coarsest grid is small (3 cells across in at least one
+		// direction), so just relax it with SOR until it is solved
+		// well enough.
+		double omega = sor_optimal_omega(lev->u.nrows, lev->u.ncols);
+		smooth(lev, omega, 2 * (lev->u.nrows + lev->u.ncols));
+		return;
+	}
+
+	smooth(lev, 1.0, PRE_SMOOTH);
+
+	Level *coarse = &levels[l+1];
+	compute_residual(lev);
+	restrict_residual(lev, coarse);
+	grid_fill(&coarse->u, 0.0);
+
+	vcycle(levels, l+1, nlevels);
+
+	prolong_correction(coarse, lev);
+	smooth(lev, 1.0, POST_SMOOTH);
+}
+
+// Free everything allocated for the levels (level 0's temperatures
+// are the caller's plate, so those are kept)
+static void free_levels(Level *levels, int nlevels) {
+	for (int l = 0; l < nlevels; l++) {
+		if (l > 0) {
+			grid_free(&levels[l].u);
+		}
+		grid_free(&levels[l].f);
+		grid_free(&levels[l].r);
+	}
+	free(levels);
+}
+
+// Solve the plate with multigrid V-cycles until the differences
+// between each cell and the average of its neighbors (in the norm
+// params->norm) are at most params->tol, or params->max_iter V-cycles
+// have been done.
+// Each V-cycle costs a few sweeps' worth of work no matter how large
+// the plate is, and reduces the error by a roughly constant factor,
+// so the total work grows only in proportion to the number of cells.
+// The plate must have 2^k+1 rows and 2^m+1 columns.
+// Returns false if the plate has the wrong size or memory could not
+// be allocated.
+bool multigrid_solve(Grid *plate, const SolveParams *params, SolveResult *result) {
+	if (!is_power_of_two(plate->nrows-1) || !is_power_of_two(plate->ncols-1)) {
+		printf("Multigrid needs 2^k+1 rows and 2^m+1 columns (e.g. 1025)\n");
+		return false;
+	}
+
+	// coarsen until one direction is only 3 cells across
+	int nlevels = 1;
+	for (int n = plate->nrows, m = plate->ncols; n > 3 && m > 3; n = (n+1)/2, m = (m+1)/2) {
+		nlevels++;
+	}
+
+	Level *levels = (Level *) calloc(nlevels, sizeof(Level));
+	if (levels == NULL) {
+		return false;
+	}
+
+	bool ok = true;
+	int nrows = plate->nrows, ncols = plate->ncols;
+	double h2 = 1.0;
+	for (int l = 0; l < nlevels && ok; l++) {
+		Level *lev = &levels[l];
+		lev->h2 = h2;
+		if (l == 0) {
+			lev->u = *plate;
+		} else {
+			ok = grid_alloc(&lev->u, nrows, ncols);
+		}
+		ok = ok && grid_alloc(&lev->f, nrows, ncols) && grid_alloc(&lev->r, nrows, ncols);
+		if (ok) {
+			grid_fill(&lev->f, 0.0);
+			grid_fill(&lev->r, 0.0);
+			if (l > 0) {
+				grid_fill(&lev->u, 0.0);
+			}
+		}
+		nrows = (nrows+1) / 2;
+		ncols = (ncols+1) / 2;
+		h2 *= 4.0;
+	}
+	if (!ok) {
+		free_levels(levels, nlevels);
+		return false;
+	}
+
+	double start = wall_time();
+
+	result->iterations = 0;
+	result->residual = 0.0;
+	result->residual_l2 = 0.0;
+	while (result->iterations < params->max_iter) {
+		vcycle(levels, 0, nlevels);
+		result->iterations++;
+
+		// on the plate h = 1 and f = 0, so |r| / 4 is how far a cell
+		// is from the average of its neighbors
+		Residual res = compute_residual(&levels[0]);
+		result->residual = res.max / 4.0;
+		result->residual_l2 = sqrt(res.sum_sq) / 4.0;
+		if (params->monitor != NULL) {
+			params->monitor(result->iterations, result->residual, result->residual_l2,
+				params->monitor_arg);
+		}
+		if (residual_converged(params, result->residual, result->residual_l2)) {
+			break;
+		}
+	}
+
+	result->seconds = wall_time() - start;
+	result->tile_cols = 0;
+	result->tile_rows = 0;
+	result->simd = SIMD_SCALAR;
+	result->nthreads = 1;
+
+	free_levels(levels, nlevels);
+	return true;
+}
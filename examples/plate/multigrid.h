@@ -0,0 +1,9 @@
+#ifndef MULTIGRID_H
+#define MULTIGRID_H
+
+#include "grid.h"
+#include "solver.h"
+
+bool multigrid_solve(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // MULTIGRID_H
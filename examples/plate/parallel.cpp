@@ -0,0 +1,148 @@
+#include <stdlib.h>
+#include "bands.h"
+#include "jacobi.h"
+#include "parallel.h"
+#include "stencil.h"
+
+// The horizontal band of interior rows updated by one thread (or, on
+// a masked plate, the spans span_begin..span_end-1 of the mask)
+struct Band {
+	int row_begin;
+	int row_end;
+	int span_begin;
+	int span_end;
+};
+
+// The plate being solved, and how it is split into bands
+struct Plate {
+	Grid grid[2];     // the plate and the second buffer
+	const Mask *mask;
+	RowUpdate update;
+	int tile_cols;
+	Band *bands;
+};
+
+// Touch our own rows of the second buffer first, so that on NUMA
+// machines they end up in memory close to this thread (a masked
+// plate's second buffer is filled in before we start).
+static void band_start(void *arg, int k) {
+	Plate *p = (Plate *) arg;
+	const Grid *cur = &p->grid[0];
+	Grid *next = &p->grid[1];
+	for (int i = p->bands[k].row_begin; i < p->bands[k].row_end && p->mask == NULL; i++) {
+		for (int j = 0; j < cur->ncols; j++) {
+			CELL(next, i, j) = CELL(cur, i, j);
+		}
+	}
+}
+
+static void band_sweep(void *arg, int k, int from, Residual *res) {
+	Plate *p = (Plate *) arg;
+	const Band *band = &p->bands[k];
+	if (p->mask != NULL) {
+		jacobi_sweep_spans(&p->grid[from], &p->grid[1-from], &p->mask->spans[band->span_begin],
+			band->span_end - band->span_begin, p->update, res);
+	} else {
+		jacobi_sweep_rows(&p->grid[from], &p->grid[1-from], band->row_begin, band->row_end,
+			p->tile_cols, p->update, res);
+	}
+}
+
+// Same as jacobi_solve, but each sweep is shared by params->nthreads
+// threads, each updating one horizontal band of the plate (see
+// bands.cpp).  On a masked plate each thread gets a run of spans with
+// about the same number of interior cells instead, since the rows can
+// be very different lengths.
+// Returns false if memory could not be allocated or the threads
+// could not be started.
+bool jacobi_solve_parallel(Grid *plate, const SolveParams *params, SolveResult *result) {
+	const Mask *mask = params->mask;
+	int interior = plate->nrows - 2;
+	int nthreads = params->nthreads;
+	if (nthreads > interior) {
+		nthreads = interior;
+	}
+	if (mask != NULL && nthreads > mask->nspans) {
+		nthreads = mask->nspans > 0 ? mask->nspans : 1;
+	}
+
+	Plate p;
+	p.grid[0] = *plate;
+	p.mask = mask;
+	p.update = row_update<double>(params->simd);
+
+	Grid *next = &p.grid[1];
+	if (!grid_alloc(next, plate->nrows, plate->ncols)) {
+		return false;
+	}
+
+	// edge rows are copied here, interior rows by the owning thread;
+	// a masked plate is copied here all at once, because fixed cells
+	// can be anywhere
+	if (mask != NULL) {
+		grid_copy(next, plate);
+	}
+	for (int j = 0; j < plate->ncols; j++) {
+		CELL(next, 0, j) = CELL(plate, 0, j);
+		CELL(next, plate->nrows-1, j) = CELL(plate, plate->nrows-1, j);
+	}
+
+	p.tile_cols = params->tile_cols;
+	if (mask != NULL) {
+		p.tile_cols = 0;
+	} else if (p.tile_cols == TILE_AUTO) {
+		grid_copy(next, plate);
+		p.tile_cols = jacobi_autotune(plate, next, p.update);
+	}
+
+	p.bands = (Band *) malloc(nthreads * sizeof(Band));
+	if (p.bands == NULL) {
+		grid_free(next);
+		return false;
+	}
+
+	// split the interior rows as evenly as possible
+	for (int k = 0; k < nthreads; k++) {
+		p.bands[k].row_begin = 1 + (long) interior * k / nthreads;
+		p.bands[k].row_end = 1 + (long) interior * (k+1) / nthreads;
+		p.bands[k].span_begin = 0;
+		p.bands[k].span_end = 0;
+	}
+
+	// or the interior cells of a masked plate, without splitting spans
+	if (mask != NULL) {
+		int s = 0;
+		long cells = 0;
+		for (int k = 0; k < nthreads; k++) {
+			p.bands[k].span_begin = s;
+			long target = mask->ncells * (k+1) / nthreads;
+			while (s < mask->nspans && (cells < target || k == nthreads-1)) {
+				cells += mask->spans[s].jend - mask->spans[s].jbegin;
+				s++;
+			}
+			p.bands[k].span_end = s;
+		}
+	}
+
+	BandSweeps sweeps;
+	sweeps.nthreads = nthreads;
+	sweeps.start = band_start;
+	sweeps.sweep = band_sweep;
+	sweeps.arg = &p;
+	bool ok = bands_solve(&sweeps, params, result);
+
+	if (ok) {
+		result->tile_cols = p.tile_cols;
+		result->tile_rows = 0;
+		result->simd = simd_resolve(params->simd);
+
+		// after an odd number of sweeps the answer is in the second buffer
+		if (result->iterations % 2 == 1) {
+			grid_swap(plate, next);
+		}
+	}
+
+	free(p.bands);
+	grid_free(next);
+	return ok;
+}
@@ -0,0 +1,9 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include "grid.h"
+#include "solver.h"
+
+bool jacobi_solve_parallel(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // PARALLEL_H
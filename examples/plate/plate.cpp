@@ -0,0 +1,726 @@
+// Simulate heat transfer on a rectangular plate.
+//
+// With no arguments, this behaves like the classroom example:
+// a 10x10 plate, one update of the interior, and both tables printed.
+//
+// With arguments, it iterates to convergence on a plate of any size:
+//
+//   plate.exe -r ROWS -c COLS [-t TOL] [-m MAXITER] [-T WIDTH|auto]
+//             [-S STEPS] [-R ROWS] [-s scalar|avx2|avx512|auto] [-j THREADS]
+//             [-M jacobi|sor|multigrid|cg|all] [-w OMEGA] [-C jacobi|ic]
+//             [-P double|float|mixed|all] [-n max|l2] [-k K] [-H FILE]
+//             [-D MASK.pgm] [-i FILE] [-o FILE] [-p]
+//             [-e STEPS [-a ALPHA] [-d DT] [-f N] [-F PREFIX]]
+//
+// The edge temperatures are still read from standard input, so a
+// large run can be done with, e.g.
+//
+//   echo 100 0 50 25 | ./plate.exe -r 4096 -c 4096 -t 1e-3 -o plate.bin
+//
+// -o FILE saves the final temperatures in a binary grid file, and
+// -i FILE starts from such a file instead of a fresh plate, so a run
+// stopped by -m can be continued later.  -p prints the temperature
+// tables (for plates up to 20x20).
+//
+// The residual is how much the cells changed in a sweep, and -t TOL
+// applies to its max norm (the largest change), or to its L2 norm with
+// -n l2.  -k K only measures it every K Jacobi sweeps, which saves a
+// little work per sweep, at the cost of up to K-1 sweeps more than
+// needed.  -H FILE writes every residual measured to FILE, one
+// "iteration,max,l2" line each, to watch how the solver converges.
+//
+// -D MASK.pgm solves a plate of any shape, given as a PGM image with
+// one pixel per cell: white cells are solved for, and every other cell
+// is held at its gray level in degrees (black = 0).  The plate size
+// comes from the image, and no temperatures are read.  With -i, the
+// saved grid supplies all of the temperatures and the image just says
+// which cells to solve for.  bracket.pgm is an example:
+//
+//   ./plate.exe -D bracket.pgm -p
+//
+// Masked plates can only be solved with the jacobi method, untiled.
+//
+// -M cg solves the plate as a linear system with conjugate gradients,
+// preconditioned with IC(0) (or Jacobi, with -C jacobi).  It needs far
+// fewer iterations than sweeping, which matters most for tight
+// tolerances on large plates.
+//
+// -M all solves the same plate with every method (and CG with each
+// preconditioner) and prints the iterations and time each one needed.
+//
+// -P all solves the same plate with Jacobi in each precision and
+// prints the time each one needed and how far its answer is from the
+// double precision answer.
+//
+// -e STEPS simulates how the plate heats up instead of solving for
+// its final temperatures: it takes STEPS explicit time steps of the
+// heat equation with diffusivity ALPHA (-a, default 1) and time step DT
+// (-d, default the largest stable one, 0.25 / ALPHA; larger ones are
+// refused).  -f N saves a frame every N steps, in grid files named
+// PREFIX<step>.bin (-F, default "frame"), to make an animation from;
+// a run restarted with -i keeps to the same steps.
+// The frames are written by a background thread, so the steps carry on
+// while they go to disk; the summary says how much of the writing was
+// hidden that way.  For example
+//
+//   echo 100 0 50 25 | ./plate.exe -r 1024 -c 1024 -e 20000 -f 1000
+//
+// -b SWEEPS times SWEEPS untiled and tiled sweeps (and temporally
+// blocked sweeps, with -S) instead of solving, and reports the
+// effective memory bandwidth of each.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "framewriter.h"
+#include "grid.h"
+#include "gridio.h"
+#include "jacobi.h"
+#include "mask.h"
+#include "solver.h"
+#include "stencil.h"
+#include "temporal.h"
+#include "timer.h"
+#include "transient.h"
+
+// grids larger than this are not printed
+#define MAX_PRINT 20
+
+struct Options {
+	int nrows;
+	int ncols;
+	SolveParams params;
+	HeatParams heat;
+	bool solver_mode;
+	bool compare;
+	bool compare_precision;
+	int bandwidth_sweeps;
+	bool print;
+	const char *input_file;
+	const char *output_file;
+	const char *history_file;
+	const char *mask_file;
+};
+
+bool parse_options(int argc, char *argv[], Options *opts);
+void usage(void);
+bool report_bandwidth(const Grid *plate, const SolveParams *params, int sweeps);
+bool compare_methods(const Grid *plate, const SolveParams *params);
+bool compare_precisions(const Grid *plate, const SolveParams *params);
+bool run_transient(Grid *plate, const Options *opts, long start_iteration);
+void write_history(long iteration, double max_change, double l2, void *arg);
+
+int main(int argc, char *argv[]) {
+	Options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+
+	Grid plate;
+	long start_iteration = 0;
+	double start_residual = 0.0;
+
+	if (opts.input_file != NULL) {
+		// carry on from a saved grid
+		if (!grid_read(opts.input_file, &plate, &start_iteration, &start_residual)) {
+			return 1;
+		}
+		opts.nrows = plate.nrows;
+		opts.ncols = plate.ncols;
+	} else if (opts.mask_file == NULL) {
+		double left, right, top, bottom;
+
+		printf("Left temperature: ");
+		scanf("%lf", &left);
+		printf("Right temperature: ");
+		scanf("%lf", &right);
+		printf("Top temperature: ");
+		scanf("%lf", &top);
+		printf("Bottom temperature: ");
+		scanf("%lf", &bottom);
+
+		if (!grid_alloc(&plate, opts.nrows, opts.ncols)) {
+			printf("Not enough memory for a %ix%i plate\n", opts.nrows, opts.ncols);
+			return 1;
+		}
+		grid_init(&plate, left, right, top, bottom);
+	}
+
+	Mask mask;
+	mask.spans = NULL;
+	if (opts.mask_file != NULL) {
+		Grid fixed;
+		if (!mask_read(opts.mask_file, &mask, &fixed)) {
+			if (opts.input_file != NULL) {
+				grid_free(&plate);
+			}
+			return 1;
+		}
+
+		if (opts.input_file == NULL) {
+			plate = fixed;
+		} else {
+			// the saved grid already holds the fixed temperatures
+			bool same_size = fixed.nrows == plate.nrows && fixed.ncols == plate.ncols;
+			grid_free(&fixed);
+			if (!same_size) {
+				printf("%s and %s are different sizes\n", opts.mask_file, opts.input_file);
+				mask_free(&mask);
+				grid_free(&plate);
+				return 1;
+			}
+		}
+		opts.nrows = plate.nrows;
+		opts.ncols = plate.ncols;
+		opts.params.mask = &mask;
+		opts.heat.mask = &mask;
+	}
+
+	if (opts.bandwidth_sweeps > 0) {
+		bool ok = report_bandwidth(&plate, &opts.params, opts.bandwidth_sweeps);
+		grid_free(&plate);
+		if (!ok) {
+			printf("Not enough memory for a %ix%i plate\n", opts.nrows, opts.ncols);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (opts.compare) {
+		bool ok = compare_methods(&plate, &opts.params);
+		mask_free(&mask);
+		grid_free(&plate);
+		if (!ok) {
+			printf("Not enough memory for a %ix%i plate\n", opts.nrows, opts.ncols);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (opts.compare_precision) {
+		bool ok = compare_precisions(&plate, &opts.params);
+		mask_free(&mask);
+		grid_free(&plate);
+		if (!ok) {
+			printf("Not enough memory for a %ix%i plate\n", opts.nrows, opts.ncols);
+			return 1;
+		}
+		return 0;
+	}
+
+	if (opts.heat.steps > 0) {
+		bool ok = run_transient(&plate, &opts, start_iteration);
+		mask_free(&mask);
+		grid_free(&plate);
+		return ok ? 0 : 1;
+	}
+
+	FILE *history = NULL;
+	if (opts.history_file != NULL) {
+		history = fopen(opts.history_file, "w");
+		if (history == NULL) {
+			printf("Can't write to %s\n", opts.history_file);
+			mask_free(&mask);
+			grid_free(&plate);
+			return 1;
+		}
+		fprintf(history, "iteration,max,l2\n");
+		opts.params.monitor = write_history;
+		opts.params.monitor_arg = history;
+	}
+
+	bool print = opts.print && opts.nrows <= MAX_PRINT && opts.ncols <= MAX_PRINT;
+
+	// print original temperatures
+	if (print) {
+		printf("Original temperatures:\n");
+		grid_print(&plate);
+	}
+
+	SolveResult result;
+	bool solved = solve(&plate, &opts.params, &result);
+	if (history != NULL) {
+		fclose(history);
+	}
+	if (!solved) {
+		printf("Could not run the solver\n");
+		mask_free(&mask);
+		grid_free(&plate);
+		return 1;
+	}
+
+	// print updated temperatures
+	if (print) {
+		printf("Updated temperatures:\n");
+		grid_print(&plate);
+	}
+
+	if (opts.output_file != NULL) {
+		long iteration = start_iteration + result.iterations;
+		if (!grid_write(opts.output_file, &plate, iteration, result.residual)) {
+			mask_free(&mask);
+			grid_free(&plate);
+			return 1;
+		}
+	}
+
+	if (opts.solver_mode) {
+		printf("Method:     %s\n", method_name(opts.params.method));
+		if (opts.mask_file != NULL) {
+			printf("Mask:       %s (%li cells to solve, in %i runs)\n", opts.mask_file,
+				mask.ncells, mask.nspans);
+		}
+		if (start_iteration > 0) {
+			printf("Restarted:  after %li iterations (residual %g)\n",
+				start_iteration, start_residual);
+		}
+		printf("Iterations: %li\n", result.iterations);
+		if (opts.params.precision != PRECISION_DOUBLE) {
+			printf("Precision:  %s (%li sweeps in float)\n",
+				precision_name(opts.params.precision), result.float_iterations);
+		}
+		printf("Residual:   %g (L2 %g)\n", result.residual, result.residual_l2);
+		if (opts.params.check_every > 1 && opts.params.method == METHOD_JACOBI) {
+			printf("Checked:    every %i sweeps\n", opts.params.check_every);
+		}
+		printf("Time:       %.3lf s\n", result.seconds);
+		printf("SIMD:       %s\n", simd_name(result.simd));
+		if (result.nthreads > 1) {
+			printf("Threads:    %i\n", result.nthreads);
+		}
+		if (result.tile_rows > 0) {
+			printf("Temporal:   %i sweeps per %ix%i tile\n", opts.params.time_steps,
+				result.tile_rows, result.tile_cols);
+		} else if (result.tile_cols > 0) {
+			printf("Tile width: %i\n", result.tile_cols);
+		}
+		if (opts.params.method == METHOD_SOR) {
+			printf("Omega:      %.6lf\n", result.omega);
+		}
+		if (opts.params.method == METHOD_CG) {
+			printf("Precond:    %s\n", preconditioner_name(opts.params.preconditioner));
+		}
+	}
+
+	mask_free(&mask);
+	grid_free(&plate);
+
+	return 0;
+}
+
+// Read the command line arguments into opts.
+// Returns false if they don't make sense.
+bool parse_options(int argc, char *argv[], Options *opts) {
+	// defaults reproduce the classroom example: one sweep of a 10x10 plate
+	opts->nrows = 10;
+	opts->ncols = 10;
+	solve_params_init(&opts->params);
+	opts->solver_mode = argc > 1;
+	opts->compare = false;
+	opts->compare_precision = false;
+	opts->bandwidth_sweeps = 0;
+	opts->print = !opts->solver_mode;
+	opts->input_file = NULL;
+	opts->output_file = NULL;
+	opts->history_file = NULL;
+	opts->mask_file = NULL;
+	opts->heat.alpha = 1.0;
+	opts->heat.dt = 0.0;
+	opts->heat.steps = 0;
+	opts->heat.frame_every = 0;
+	opts->heat.frame_prefix = "frame";
+	opts->heat.mask = NULL;
+
+	// solver mode keeps going until (nearly) converged, but the
+	// classroom example does exactly one sweep
+	if (!opts->solver_mode) {
+		opts->params.tol = 0.0;
+		opts->params.max_iter = 1;
+	}
+
+	for (int i = 1; i < argc; i++) {
+		// options without a value
+		if (strcmp(argv[i], "-p") == 0) {
+			opts->print = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-r") == 0) {
+			opts->nrows = atoi(value);
+		} else if (strcmp(argv[i], "-c") == 0) {
+			opts->ncols = atoi(value);
+		} else if (strcmp(argv[i], "-t") == 0) {
+			opts->params.tol = atof(value);
+		} else if (strcmp(argv[i], "-m") == 0) {
+			opts->params.max_iter = atol(value);
+		} else if (strcmp(argv[i], "-T") == 0) {
+			opts->params.tile_cols = (strcmp(value, "auto") == 0) ? TILE_AUTO : atoi(value);
+		} else if (strcmp(argv[i], "-S") == 0) {
+			opts->params.time_steps = atoi(value);
+		} else if (strcmp(argv[i], "-R") == 0) {
+			opts->params.tile_rows = atoi(value);
+		} else if (strcmp(argv[i], "-s") == 0) {
+			if (!simd_from_name(value, &opts->params.simd)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->params.nthreads = atoi(value);
+		} else if (strcmp(argv[i], "-M") == 0) {
+			if (strcmp(value, "all") == 0) {
+				opts->compare = true;
+			} else {
+				opts->params.method = method_from_name(value);
+				if (opts->params.method < 0) {
+					return false;
+				}
+			}
+		} else if (strcmp(argv[i], "-w") == 0) {
+			opts->params.omega = atof(value);
+		} else if (strcmp(argv[i], "-C") == 0) {
+			opts->params.preconditioner = preconditioner_from_name(value);
+			if (opts->params.preconditioner < 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-P") == 0) {
+			if (strcmp(value, "all") == 0) {
+				opts->compare_precision = true;
+			} else {
+				opts->params.precision = precision_from_name(value);
+				if (opts->params.precision < 0) {
+					return false;
+				}
+			}
+		} else if (strcmp(argv[i], "-n") == 0) {
+			opts->params.norm = norm_from_name(value);
+			if (opts->params.norm < 0) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-k") == 0) {
+			opts->params.check_every = atoi(value);
+		} else if (strcmp(argv[i], "-H") == 0) {
+			opts->history_file = value;
+		} else if (strcmp(argv[i], "-D") == 0) {
+			opts->mask_file = value;
+		} else if (strcmp(argv[i], "-i") == 0) {
+			opts->input_file = value;
+		} else if (strcmp(argv[i], "-o") == 0) {
+			opts->output_file = value;
+		} else if (strcmp(argv[i], "-b") == 0) {
+			opts->bandwidth_sweeps = atoi(value);
+		} else if (strcmp(argv[i], "-e") == 0) {
+			opts->heat.steps = atol(value);
+		} else if (strcmp(argv[i], "-a") == 0) {
+			opts->heat.alpha = atof(value);
+		} else if (strcmp(argv[i], "-d") == 0) {
+			opts->heat.dt = atof(value);
+		} else if (strcmp(argv[i], "-f") == 0) {
+			opts->heat.frame_every = atoi(value);
+		} else if (strcmp(argv[i], "-F") == 0) {
+			opts->heat.frame_prefix = value;
+		} else {
+			return false;
+		}
+		i++;
+	}
+
+	return opts->nrows >= 3 && opts->ncols >= 3 && opts->params.max_iter >= 0
+		&& opts->params.nthreads >= 1 && opts->params.check_every >= 1
+		&& !(opts->mask_file != NULL && opts->bandwidth_sweeps > 0)
+		&& opts->heat.steps >= 0 && opts->heat.alpha > 0.0 && opts->heat.dt >= 0.0
+		&& opts->heat.frame_every >= 0
+		&& !(opts->heat.steps > 0 && (opts->compare || opts->compare_precision
+			|| opts->bandwidth_sweeps > 0));
+}
+
+void usage(void) {
+	printf("Usage: plate.exe [-r ROWS] [-c COLS] [-t TOL] [-m MAXITER] [-T WIDTH|auto]\n");
+	printf("                 [-S STEPS] [-R ROWS] [-s scalar|avx2|avx512|auto] [-j THREADS]\n");
+	printf("                 [-M jacobi|sor|multigrid|cg|all] [-w OMEGA] [-C jacobi|ic]\n");
+	printf("                 [-P double|float|mixed|all] [-n max|l2] [-k K] [-H FILE]\n");
+	printf("                 [-D MASK.pgm] [-i FILE] [-o FILE] [-p] [-b SWEEPS]\n");
+	printf("                 [-e STEPS [-a ALPHA] [-d DT] [-f N] [-F PREFIX]]\n");
+	printf("  -r ROWS     number of rows (default 10)\n");
+	printf("  -c COLS     number of columns (default 10)\n");
+	printf("  -t TOL      stop when the residual is at most TOL (default 1e-4)\n");
+	printf("  -n NORM     measure the residual by the largest change of any cell (max,\n");
+	printf("              the default) or by the L2 norm of the changes (l2)\n");
+	printf("  -k K        only measure the residual every K jacobi sweeps (default 1)\n");
+	printf("  -H FILE     write every residual measured to FILE (iteration,max,l2)\n");
+	printf("  -m MAXITER  stop after at most MAXITER sweeps (default 1000000)\n");
+	printf("  -T WIDTH    sweep in cache tiles WIDTH columns wide, or \"auto\" to autotune\n");
+	printf("  -S STEPS    do STEPS sweeps at a time on each cache tile (temporal blocking,\n");
+	printf("              one thread); the tile is ROWS by WIDTH (default %ix%i)\n",
+		TEMPORAL_TILE_ROWS, TEMPORAL_TILE_COLS);
+	printf("  -R ROWS     height of the temporal blocking tiles\n");
+	printf("  -s SIMD     instruction set for the sweeps (default: widest supported)\n");
+	printf("  -j THREADS  number of threads, each sweeping a band of rows (default 1)\n");
+	printf("  -M METHOD   solver to use (default jacobi), or \"all\" to compare them;\n");
+	printf("              multigrid needs 2^k+1 rows and columns\n");
+	printf("  -w OMEGA    SOR relaxation factor (default: optimal for the plate size)\n");
+	printf("  -C PRECOND  preconditioner for cg (default ic)\n");
+	printf("  -P PREC     cell type for jacobi sweeps (default double), or \"all\" to compare;\n");
+	printf("              float sweeps use one thread\n");
+	printf("  -D MASK     solve only the white cells of a PGM image, holding the others at\n");
+	printf("              their gray level (jacobi only, not with -b)\n");
+	printf("  -i FILE     start from a saved grid file instead of reading temperatures\n");
+	printf("  -o FILE     save the final temperatures to a binary grid file\n");
+	printf("  -p          print the temperature tables (plates up to %ix%i)\n", MAX_PRINT, MAX_PRINT);
+	printf("  -b SWEEPS   time SWEEPS untiled, tiled (and temporal) sweeps and report bandwidth\n");
+	printf("  -e STEPS    take STEPS time steps of the heat equation instead of solving\n");
+	printf("  -a ALPHA    thermal diffusivity for -e (default 1)\n");
+	printf("  -d DT       time step for -e (default: the largest stable one, 0.25 / ALPHA)\n");
+	printf("  -f N        with -e, save a frame every N steps (written in the background)\n");
+	printf("  -F PREFIX   frames are saved as PREFIX<step>.bin (default \"frame\")\n");
+	printf("With no arguments, one sweep of a 10x10 plate is done and printed.\n");
+}
+
+// Time the given number of untiled sweeps and tiled sweeps of the plate
+// (and temporally blocked sweeps, if params->time_steps > 1), and print
+// the effective memory bandwidth of each.  Every interior cell has to
+// be read once and written once per sweep, so a sweep moves at least
+// 16 bytes per interior cell; more traffic than that (rows fetched
+// from memory several times) shows up as lower bandwidth, and less
+// (cells reused across sweeps while in cache) as higher.
+// Returns false if the work buffers could not be allocated.
+bool report_bandwidth(const Grid *plate, const SolveParams *params, int sweeps) {
+	Grid a, b;
+	if (!grid_alloc(&a, plate->nrows, plate->ncols)) {
+		return false;
+	}
+	if (!grid_alloc(&b, plate->nrows, plate->ncols)) {
+		grid_free(&a);
+		return false;
+	}
+	grid_copy(&a, plate);
+	grid_copy(&b, plate);
+
+	// the residual is measured on every sweep, as the solver does by default
+	Residual res;
+	RowUpdate update = row_update<double>(params->simd);
+	int tile_cols = params->tile_cols;
+	if (tile_cols == TILE_AUTO) {
+		tile_cols = jacobi_autotune(&a, &b, update);
+	}
+
+	double bytes = 16.0 * (plate->nrows-2) * (plate->ncols-2) * sweeps;
+
+	double start = wall_time();
+	for (int k = 0; k < sweeps; k++) {
+		jacobi_sweep(&a, &b, update, &res);
+		grid_swap(&a, &b);
+	}
+	double naive = wall_time() - start;
+
+	start = wall_time();
+	for (int k = 0; k < sweeps; k++) {
+		jacobi_sweep_tiled(&a, &b, tile_cols, update, &res);
+		grid_swap(&a, &b);
+	}
+	double tiled = wall_time() - start;
+
+	printf("SIMD:             %s\n", simd_name(simd_resolve(params->simd)));
+	printf("Untiled:          %8.3lf s  %7.2lf GB/s\n", naive, bytes / naive * 1e-9);
+	printf("Tiled:            %8.3lf s  %7.2lf GB/s  (width %i)\n", tiled, bytes / tiled * 1e-9, tile_cols);
+
+	if (params->time_steps > 1) {
+		int steps = params->time_steps;
+		int tile_rows = params->tile_rows > 0 ? params->tile_rows : TEMPORAL_TILE_ROWS;
+		int temporal_cols = params->tile_cols > 0 ? params->tile_cols : TEMPORAL_TILE_COLS;
+
+		start = wall_time();
+		for (int k = 0; k < sweeps; k += steps) {
+			int n = (sweeps - k < steps) ? sweeps - k : steps;
+			jacobi_sweeps_temporal(&a, &b, n, tile_rows, temporal_cols, update, &res);
+			if (n % 2 == 1) {
+				grid_swap(&a, &b);
+			}
+		}
+		double temporal = wall_time() - start;
+
+		printf("Temporal:         %8.3lf s  %7.2lf GB/s  (%i sweeps per %ix%i tile)\n",
+			temporal, bytes / temporal * 1e-9, steps, tile_rows, temporal_cols);
+	}
+
+	grid_free(&a);
+	grid_free(&b);
+	return true;
+}
+
+// Solve a copy of the plate with each method in turn (and conjugate
+// gradients with each preconditioner), and print how many sweeps and
+// how much time each one needed to reach the tolerance.
+// Methods that can't handle this plate are listed as such.
+// Returns false if the work buffer could not be allocated.
+bool compare_methods(const Grid *plate, const SolveParams *params) {
+	Grid work;
+	if (!grid_alloc(&work, plate->nrows, plate->ncols)) {
+		return false;
+	}
+
+	printf("%-10s %12s %14s %10s\n", "Method", "Iterations", "Residual", "Time (s)");
+
+	for (int m = 0; m < NUM_METHODS; m++) {
+		int variants = (m == METHOD_CG) ? NUM_PRECONDITIONERS : 1;
+		for (int v = 0; v < variants; v++) {
+			SolveParams method_params = *params;
+			method_params.method = m;
+			method_params.preconditioner = v;
+
+			char name[32];
+			if (m == METHOD_CG) {
+				snprintf(name, sizeof(name), "%s-%s", method_name(m), preconditioner_name(v));
+			} else {
+				snprintf(name, sizeof(name), "%s", method_name(m));
+			}
+
+			grid_copy(&work, plate);
+
+			SolveResult result;
+			if (solve(&work, &method_params, &result)) {
+				printf("%-10s %12li %14g %10.3lf\n", name,
+					result.iterations, result.residual, result.seconds);
+			} else {
+				printf("%-10s %12s\n", name, "(not run)");
+			}
+		}
+	}
+
+	grid_free(&work);
+	return true;
+}
+
+// Solve a copy of the plate with Jacobi in each precision, and print
+// the sweeps and time each one needed, and the largest difference
+// between its temperatures and the double precision temperatures.
+// Returns false if memory could not be allocated.
+bool compare_precisions(const Grid *plate, const SolveParams *params) {
+	Grid reference, work;
+	if (!grid_alloc(&reference, plate->nrows, plate->ncols)) {
+		return false;
+	}
+	if (!grid_alloc(&work, plate->nrows, plate->ncols)) {
+		grid_free(&reference);
+		return false;
+	}
+
+	printf("%-10s %12s %12s %14s %10s %14s\n", "Precision", "Iterations", "In float",
+		"Residual", "Time (s)", "Max error");
+
+	bool ok = true;
+	for (int p = 0; p < NUM_PRECISIONS && ok; p++) {
+		SolveParams prec_params = *params;
+		prec_params.method = METHOD_JACOBI;
+		prec_params.precision = p;
+
+		// the double answer is kept as the reference for the others
+		Grid *result_grid = (p == PRECISION_DOUBLE) ? &reference : &work;
+		grid_copy(result_grid, plate);
+
+		SolveResult result;
+		ok = solve(result_grid, &prec_params, &result);
+		if (ok) {
+			printf("%-10s %12li %12li %14g %10.3lf %14g\n", precision_name(p),
+				result.iterations, result.float_iterations, result.residual,
+				result.seconds, grid_max_diff(result_grid, &reference));
+		}
+	}
+
+	grid_free(&reference);
+	grid_free(&work);
+	return ok;
+}
+
+// Residual monitor that appends each residual to a history file
+// (arg is the open FILE)
+void write_history(long iteration, double max_change, double l2, void *arg) {
+	fprintf((FILE *) arg, "%li,%g,%g\n", iteration, max_change, l2);
+}
+
+// Take the time steps asked for with -e on the plate (see heat_run),
+// print the tables and save the result as for a solve, and print a
+// summary, including how much of the frame writing overlapped the
+// steps.  A restarted run carries on numbering steps from the saved
+// grid's iteration count.
+// Returns false (after printing why) if the time step is unstable or
+// the run failed.
+bool run_transient(Grid *plate, const Options *opts, long start_iteration) {
+	HeatParams heat = opts->heat;
+	heat.simd = opts->params.simd;
+	double max_dt = heat_max_dt(heat.alpha);
+	if (heat.dt == 0.0) {
+		heat.dt = max_dt;
+	} else if (heat.dt > max_dt) {
+		printf("Time step %g is unstable: with diffusivity %g it can be at most %g\n",
+			heat.dt, heat.alpha, max_dt);
+		return false;
+	}
+
+	bool print = opts->print && opts->nrows <= MAX_PRINT && opts->ncols <= MAX_PRINT;
+	if (print) {
+		printf("Original temperatures:\n");
+		grid_print(plate);
+	}
+
+	HeatResult result;
+	if (!heat_run(plate, &heat, start_iteration, &result)) {
+		printf("Could not run the time steps\n");
+		return false;
+	}
+
+	if (print) {
+		printf("Updated temperatures:\n");
+		grid_print(plate);
+	}
+
+	long last_step = start_iteration + result.steps;
+	if (opts->output_file != NULL
+			&& !grid_write(opts->output_file, plate, last_step, result.residual)) {
+		return false;
+	}
+
+	printf("Mode:       transient\n");
+	if (start_iteration > 0) {
+		printf("Restarted:  after %li steps\n", start_iteration);
+	}
+	printf("Steps:      %li of dt %g (t = %g)\n", result.steps, heat.dt,
+		result.steps * heat.dt);
+	printf("Stability:  alpha*dt = %g (at most %g)\n", heat.alpha * heat.dt, HEAT_MAX_COEF);
+	printf("Change:     %g in the last step (L2 %g)\n", result.residual, result.residual_l2);
+	printf("Time:       %.3lf s (stepping %.3lf s, copying frames %.3lf s)\n",
+		result.seconds, result.step_seconds, result.copy_seconds);
+	printf("SIMD:       %s\n", simd_name(simd_resolve(heat.simd)));
+	if (heat.frame_every > 0) {
+		// the frames are the multiples of frame_every from the first step
+		// to the last (see heat_run)
+		long every = heat.frame_every;
+		char first[FRAME_NAME_MAX], last[FRAME_NAME_MAX];
+		frame_name(first, sizeof(first), heat.frame_prefix,
+			(start_iteration + every - 1) / every * every);
+		frame_name(last, sizeof(last), heat.frame_prefix, last_step / every * every);
+		if (result.frames > 0) {
+			printf("Frames:     %i, every %i steps (%s to %s)\n", result.frames,
+				heat.frame_every, first, last);
+		} else {
+			printf("Frames:     none, every %i steps\n", heat.frame_every);
+		}
+
+		// writing that the steps had to wait for, during the run or at
+		// the end, was not overlapped
+		double exposed = result.wait_seconds + result.drain_seconds;
+		double overlap = 0.0;
+		if (result.write_seconds > 0.0) {
+			overlap = 100.0 * (result.write_seconds - exposed) / result.write_seconds;
+			if (overlap < 0.0) {
+				overlap = 0.0;
+			}
+		}
+		printf("Writer:     %.3lf s writing, %.3lf s waited for (%.1lf%% overlapped)\n",
+			result.write_seconds, exposed, overlap);
+	}
+	return true;
+}
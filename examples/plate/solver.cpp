@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <string.h>
+#include "cg.h"
+#include "jacobi.h"
+#include "multigrid.h"
+#include "solver.h"
+#include "sor.h"
+#include "stencil.h"
+
+// Default settings: Jacobi in double on one thread, with the widest
+// SIMD instructions available, until no cell changes by more than 1e-4
+// (checked after every sweep)
+void solve_params_init(SolveParams *params) {
+	params->method = METHOD_JACOBI;
+	params->tol = 1e-4;
+	params->norm = NORM_MAX;
+	params->check_every = 1;
+	params->max_iter = 1000000;
+	params->tile_cols = 0;
+	params->tile_rows = 0;
+	params->time_steps = 0;
+	params->simd = SIMD_AUTO;
+	params->nthreads = 1;
+	params->omega = 0.0;
+	params->preconditioner = PRECOND_IC;
+	params->precision = PRECISION_DOUBLE;
+	params->mask = NULL;
+	params->monitor = NULL;
+	params->monitor_arg = NULL;
+}
+
+// Names of the methods, indexed by Method
+static const char *method_names[] = { "jacobi", "sor", "multigrid", "cg" };
+
+const char *method_name(int method) {
+	return method_names[method];
+}
+
+// Look up a method by name.
+// Returns -1 if there is no method with that name.
+int method_from_name(const char *name) {
+	for (int m = 0; m < NUM_METHODS; m++) {
+		if (strcmp(name, method_names[m]) == 0) {
+			return m;
+		}
+	}
+	return -1;
+}
+
+// Names of the precisions, indexed by Precision
+static const char *precision_names[] = { "double", "float", "mixed" };
+
+const char *precision_name(int precision) {
+	return precision_names[precision];
+}
+
+// Look up a precision by name.
+// Returns -1 if there is no precision with that name.
+int precision_from_name(const char *name) {
+	for (int p = 0; p < NUM_PRECISIONS; p++) {
+		if (strcmp(name, precision_names[p]) == 0) {
+			return p;
+		}
+	}
+	return -1;
+}
+
+// Names of the preconditioners, indexed by Preconditioner
+static const char *preconditioner_names[] = { "jacobi", "ic" };
+
+const char *preconditioner_name(int preconditioner) {
+	return preconditioner_names[preconditioner];
+}
+
+// Look up a preconditioner by name.
+// Returns -1 if there is no preconditioner with that name.
+int preconditioner_from_name(const char *name) {
+	for (int p = 0; p < NUM_PRECONDITIONERS; p++) {
+		if (strcmp(name, preconditioner_names[p]) == 0) {
+			return p;
+		}
+	}
+	return -1;
+}
+
+// Names of the norms, indexed by Norm
+static const char *norm_names[] = { "max", "l2" };
+
+const char *norm_name(int norm) {
+	return norm_names[norm];
+}
+
+// Look up a norm by name.
+// Returns -1 if there is no norm with that name.
+int norm_from_name(const char *name) {
+	for (int n = 0; n < NUM_NORMS; n++) {
+		if (strcmp(name, norm_names[n]) == 0) {
+			return n;
+		}
+	}
+	return -1;
+}
+
+// Whether a residual with the given max and L2 norms meets the
+// tolerance, in the norm chosen in params->norm
+bool residual_converged(const SolveParams *params, double max_change, double l2) {
+	double residual = (params->norm == NORM_L2) ? l2 : max_change;
+	return residual <= params->tol;
+}
+
+// Solve the plate with the method chosen in params->method.
+// Returns false if the solver could not run (out of memory, etc.).
+bool solve(Grid *plate, const SolveParams *params, SolveResult *result) {
+	result->omega = 0.0;
+	result->float_iterations = 0;
+	result->residual_l2 = 0.0;
+
+	if (params->mask != NULL && params->method != METHOD_JACOBI) {
+		printf("Only the jacobi method can solve a masked plate\n");
+		return false;
+	}
+
+	switch (params->method) {
+	case METHOD_SOR:
+		return sor_solve(plate, params, result);
+	case METHOD_MULTIGRID:
+		return multigrid_solve(plate, params, result);
+	case METHOD_CG:
+		return cg_solve(plate, params, result);
+	default:
+		return jacobi_solve(plate, params, result);
+	}
+}
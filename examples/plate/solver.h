@@ -0,0 +1,94 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "grid.h"
+
+struct Mask;
+
+// tile_cols value asking the solver to pick the tile width itself
+#define TILE_AUTO -1
+
+// Ways of solving for the steady-state plate temperatures
+enum Method {
+	METHOD_JACOBI,    // average of neighbors, into a second buffer
+	METHOD_SOR,       // red-black successive over-relaxation, in place
+	METHOD_MULTIGRID, // multigrid V-cycles (2^k+1 rows and columns)
+	METHOD_CG,        // preconditioned conjugate gradients
+	NUM_METHODS
+};
+
+// Preconditioners for conjugate gradients
+enum Preconditioner {
+	PRECOND_JACOBI,   // divide by the diagonal
+	PRECOND_IC,       // incomplete Cholesky, IC(0)
+	NUM_PRECONDITIONERS
+};
+
+// Cell types the Jacobi sweeps can be done in
+enum Precision {
+	PRECISION_DOUBLE,
+	PRECISION_FLOAT,
+	PRECISION_MIXED,  // float until nearly converged, then double
+	NUM_PRECISIONS
+};
+
+// Ways of measuring the residual for the tolerance
+enum Norm {
+	NORM_MAX,         // largest change of any cell
+	NORM_L2,          // square root of the sum of the squared changes
+	NUM_NORMS
+};
+
+// Called each time a solver measures the residual, with the number of
+// sweeps (or V-cycles) done so far and the residual in both norms
+typedef void (*ResidualMonitor)(long iteration, double max_change, double l2, void *arg);
+
+// Settings shared by all of the plate solvers
+struct SolveParams {
+	int method;       // which solver to use (a Method)
+	double tol;       // stop once the residual is at most this
+	int norm;         // norm the residual is measured in for tol (a Norm)
+	int check_every;  // measure the residual only every this many Jacobi sweeps
+	long max_iter;    // stop after this many sweeps regardless
+	int tile_cols;    // width of cache tiles (0 = untiled, TILE_AUTO = autotune)
+	int tile_rows;    // height of temporal blocking tiles (0 = default)
+	int time_steps;   // sweeps per temporal block (0 or 1 = no temporal blocking)
+	int simd;         // instruction set for the sweeps (a SimdLevel)
+	int nthreads;     // number of threads sharing each sweep
+	double omega;     // SOR relaxation factor (0 = optimal for the plate)
+	int preconditioner;  // for conjugate gradients (a Preconditioner)
+	int precision;    // cell type for Jacobi sweeps (a Precision)
+	const Mask *mask; // if not NULL, only these cells are solved for (Jacobi only)
+	ResidualMonitor monitor;  // if not NULL, told every residual measured
+	void *monitor_arg;        // passed on to monitor
+};
+
+// What a solver reports back when it finishes
+struct SolveResult {
+	long iterations;  // number of sweeps (or V-cycles) performed
+	double residual;  // largest cell change in the last sweep measured
+	                  // (for SOR, multigrid and CG, the largest difference between
+	                  // a cell and the average of its neighbors)
+	double residual_l2;  // L2 norm of the changes in that sweep
+	double seconds;   // wall time spent iterating
+	int tile_cols;    // tile width actually used
+	int tile_rows;    // temporal tile height actually used (0 = none)
+	int simd;         // instruction set actually used
+	int nthreads;     // number of threads actually used
+	double omega;     // SOR relaxation factor actually used
+	long float_iterations;  // how many of the sweeps were done in float
+};
+
+void solve_params_init(SolveParams *params);
+const char *method_name(int method);
+int method_from_name(const char *name);
+const char *precision_name(int precision);
+int precision_from_name(const char *name);
+const char *preconditioner_name(int preconditioner);
+int preconditioner_from_name(const char *name);
+const char *norm_name(int norm);
+int norm_from_name(const char *name);
+bool residual_converged(const SolveParams *params, double max_change, double l2);
+bool solve(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // SOLVER_H
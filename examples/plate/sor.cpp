@@ -0,0 +1,101 @@
+#include <math.h>
+#include "sor.h"
+#include "stencil.h"
+#include "timer.h"
+
+// Best relaxation factor for Laplace's equation on a rectangle with
+// fixed edges.  It comes from the convergence rate of Jacobi
+// iteration on the same plate:
+//   rho = (cos(pi / (nrows-1)) + cos(pi / (ncols-1))) / 2
+//   omega = 2 / (1 + sqrt(1 - rho^2))
+double sor_optimal_omega(int nrows, int ncols) {
+	double rho = (cos(M_PI / (nrows-1)) + cos(M_PI / (ncols-1))) / 2.0;
+	return 2.0 / (1.0 + sqrt(1.0 - rho * rho));
+}
+
+// Update the interior cells of one color, in place.  A cell at row i,
+// column j is "red" (color 0) if i+j is even and "black" (color 1) if
+// it is odd.  All four neighbors of a cell have the other color, so
+// every cell of one color can be updated from the current values
+// without needing a second array.
+// The differences between each cell and the average of its neighbors,
+// before it was updated, are added into res.
+static void sor_half_sweep(Grid *plate, double omega, int color, Residual *res) {
+	double max_residual = res->max;
+	double sum_sq = res->sum_sq;
+
+	for (int i = 1; i < plate->nrows-1; i++) {
+		const double *above = &CELL(plate, i-1, 0);
+		double *row = &CELL(plate, i, 0);
+		const double *below = &CELL(plate, i+1, 0);
+
+		// first column in this row with the right color
+		int jstart = ((i + 1) % 2 == color) ? 1 : 2;
+
+		for (int j = jstart; j < plate->ncols-1; j += 2) {
+			double sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+			double residual = sum_neighbors / 4.0 - row[j];
+			row[j] += omega * residual;
+
+			if (fabs(residual) > max_residual) {
+				max_residual = fabs(residual);
+			}
+			sum_sq += residual * residual;
+		}
+	}
+
+	res->max = max_residual;
+	res->sum_sq = sum_sq;
+}
+
+// One red-black successive over-relaxation sweep: all red cells,
+// then all black cells.  With omega = 1 this is Gauss-Seidel.
+// res is set to the residuals seen (see sor_half_sweep), which are
+// comparable to the changes of a Jacobi sweep.
+void sor_sweep(Grid *plate, double omega, Residual *res) {
+	res->max = 0.0;
+	res->sum_sq = 0.0;
+	sor_half_sweep(plate, omega, 0, res);
+	sor_half_sweep(plate, omega, 1, res);
+}
+
+// Repeat SOR sweeps until the residual (in the norm params->norm) is
+// at most params->tol, or
+// params->max_iter sweeps have been done.  If params->omega is 0, the
+// optimal relaxation factor for the plate's size is used.
+// The plate is updated in place, so no second buffer is needed.
+bool sor_solve(Grid *plate, const SolveParams *params, SolveResult *result) {
+	double omega = params->omega;
+	if (omega <= 0.0) {
+		omega = sor_optimal_omega(plate->nrows, plate->ncols);
+	}
+	result->omega = omega;
+
+	double start = wall_time();
+
+	result->iterations = 0;
+	result->residual = 0.0;
+	result->residual_l2 = 0.0;
+	while (result->iterations < params->max_iter) {
+		Residual res;
+		sor_sweep(plate, omega, &res);
+		result->iterations++;
+
+		result->residual = res.max;
+		result->residual_l2 = sqrt(res.sum_sq);
+		if (params->monitor != NULL) {
+			params->monitor(result->iterations, result->residual, result->residual_l2,
+				params->monitor_arg);
+		}
+		if (residual_converged(params, result->residual, result->residual_l2)) {
+			break;
+		}
+	}
+
+	result->seconds = wall_time() - start;
+	result->tile_cols = 0;
+	result->tile_rows = 0;
+	result->simd = SIMD_SCALAR;
+	result->nthreads = 1;
+	return true;
+}
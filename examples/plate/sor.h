@@ -0,0 +1,12 @@
+#ifndef SOR_H
+#define SOR_H
+
+#include "grid.h"
+#include "solver.h"
+#include "stencil.h"
+
+double sor_optimal_omega(int nrows, int ncols);
+void sor_sweep(Grid *plate, double omega, Residual *res);
+bool sor_solve(Grid *plate, const SolveParams *params, SolveResult *result);
+
+#endif // SOR_H
@@ -0,0 +1,600 @@
+#include <math.h>
+#include <string.h>
+#include "stencil.h"
+
+// The vector versions add the four neighbors in the same order as the
+// scalar version and then multiply by 0.25, which (being a power of two)
+// rounds exactly like dividing by 4.0.  No fused multiply-add is used,
+// so every instruction set produces bit-for-bit the same temperatures.
+// The float versions follow the same rules, and match each other
+// (but not the double versions) bit for bit.  The same goes for the
+// largest change; only the sum of squared changes is added up in a
+// different order by each version, so it can differ in the last bits.
+// The 3D versions multiply by SIXTH instead of dividing by 6 (vector
+// division is much slower than the rest of the update), all of them the
+// same way, so they also match each other bit for bit.
+//
+// Each vector version ends with _mm256_zeroupper() before handing the
+// leftover cells to the scalar version.  Code compiled without AVX runs
+// much slower while the upper halves of the vector registers are dirty
+// (7x on short rows), and GCC leaves out the usual vzeroupper when the
+// call to the scalar version becomes a tail jump.
+
+void update_row_scalar(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, Residual *res) {
+	if (res == NULL) {
+		for (int j = jbegin; j < jend; j++) {
+			double sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+			out[j] = sum_neighbors / 4.0;
+		}
+		return;
+	}
+
+	double max = res->max;
+	double sum_sq = res->sum_sq;
+	for (int j = jbegin; j < jend; j++) {
+		double sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+		out[j] = sum_neighbors / 4.0;
+
+		double change = fabs(out[j] - row[j]);
+		if (change > max) {
+			max = change;
+		}
+		sum_sq += change * change;
+	}
+	res->max = max;
+	res->sum_sq = sum_sq;
+}
+
+void update_row_scalar_f(const float *above, const float *row, const float *below,
+		float *out, int jbegin, int jend, ResidualF *res) {
+	if (res == NULL) {
+		for (int j = jbegin; j < jend; j++) {
+			float sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+			out[j] = sum_neighbors / 4.0f;
+		}
+		return;
+	}
+
+	float max = res->max;
+	float sum_sq = res->sum_sq;
+	for (int j = jbegin; j < jend; j++) {
+		float sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+		out[j] = sum_neighbors / 4.0f;
+
+		float change = fabsf(out[j] - row[j]);
+		if (change > max) {
+			max = change;
+		}
+		sum_sq += change * change;
+	}
+	res->max = max;
+	res->sum_sq = sum_sq;
+}
+
+void step_row_scalar(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, double coef, Residual *res) {
+	if (res == NULL) {
+		for (int j = jbegin; j < jend; j++) {
+			double sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+			out[j] = row[j] + coef * (sum_neighbors - 4.0 * row[j]);
+		}
+		return;
+	}
+
+	double max = res->max;
+	double sum_sq = res->sum_sq;
+	for (int j = jbegin; j < jend; j++) {
+		double sum_neighbors = above[j] + below[j] + row[j-1] + row[j+1];
+		double change = coef * (sum_neighbors - 4.0 * row[j]);
+		out[j] = row[j] + change;
+
+		if (fabs(change) > max) {
+			max = fabs(change);
+		}
+		sum_sq += change * change;
+	}
+	res->max = max;
+	res->sum_sq = sum_sq;
+}
+
+// 1/6, for averaging the six neighbors of a cell in a block
+#define SIXTH (1.0 / 6.0)
+
+void update_row7_scalar(const double *below, const double *front, const double *row,
+		const double *back, const double *above, double *out, int jbegin, int jend,
+		Residual *res) {
+	if (res == NULL) {
+		for (int j = jbegin; j < jend; j++) {
+			double sum_neighbors = row[j-1] + row[j+1] + front[j] + back[j] + below[j] + above[j];
+			out[j] = sum_neighbors * SIXTH;
+		}
+		return;
+	}
+
+	double max = res->max;
+	double sum_sq = res->sum_sq;
+	for (int j = jbegin; j < jend; j++) {
+		double sum_neighbors = row[j-1] + row[j+1] + front[j] + back[j] + below[j] + above[j];
+		out[j] = sum_neighbors * SIXTH;
+
+		double change = fabs(out[j] - row[j]);
+		if (change > max) {
+			max = change;
+		}
+		sum_sq += change * change;
+	}
+	res->max = max;
+	res->sum_sq = sum_sq;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static void update_row_avx2(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, Residual *res) {
+	const __m256d quarter = _mm256_set1_pd(0.25);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 4 <= jend; j += 4) {
+			__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&above[j]), _mm256_loadu_pd(&below[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j-1]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j+1]));
+			_mm256_storeu_pd(&out[j], _mm256_mul_pd(sum, quarter));
+		}
+	} else {
+		__m256d vmax = _mm256_setzero_pd();
+		__m256d vsum_sq = _mm256_setzero_pd();
+		for (; j + 4 <= jend; j += 4) {
+			__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&above[j]), _mm256_loadu_pd(&below[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j-1]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j+1]));
+			__m256d avg = _mm256_mul_pd(sum, quarter);
+			_mm256_storeu_pd(&out[j], avg);
+
+			__m256d change = _mm256_andnot_pd(sign, _mm256_sub_pd(avg, _mm256_loadu_pd(&row[j])));
+			vmax = _mm256_max_pd(vmax, change);
+			vsum_sq = _mm256_add_pd(vsum_sq, _mm256_mul_pd(change, change));
+		}
+
+		double lanes[4], sums[4];
+		_mm256_storeu_pd(lanes, vmax);
+		_mm256_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 4; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row_scalar(above, row, below, out, j, jend, res);
+}
+
+__attribute__((target("avx512f")))
+static void update_row_avx512(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, Residual *res) {
+	const __m512d quarter = _mm512_set1_pd(0.25);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 8 <= jend; j += 8) {
+			__m512d sum = _mm512_add_pd(_mm512_loadu_pd(&above[j]), _mm512_loadu_pd(&below[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j-1]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j+1]));
+			_mm512_storeu_pd(&out[j], _mm512_mul_pd(sum, quarter));
+		}
+	} else {
+		__m512d vmax = _mm512_setzero_pd();
+		__m512d vsum_sq = _mm512_setzero_pd();
+		for (; j + 8 <= jend; j += 8) {
+			__m512d sum = _mm512_add_pd(_mm512_loadu_pd(&above[j]), _mm512_loadu_pd(&below[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j-1]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j+1]));
+			__m512d avg = _mm512_mul_pd(sum, quarter);
+			_mm512_storeu_pd(&out[j], avg);
+
+			__m512d change = _mm512_abs_pd(_mm512_sub_pd(avg, _mm512_loadu_pd(&row[j])));
+			vmax = _mm512_maskz_max_pd(0xff, vmax, change);
+			vsum_sq = _mm512_add_pd(vsum_sq, _mm512_mul_pd(change, change));
+		}
+
+		double lanes[8], sums[8];
+		_mm512_storeu_pd(lanes, vmax);
+		_mm512_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 8; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row_scalar(above, row, below, out, j, jend, res);
+}
+
+__attribute__((target("avx2")))
+static void update_row_avx2_f(const float *above, const float *row, const float *below,
+		float *out, int jbegin, int jend, ResidualF *res) {
+	const __m256 quarter = _mm256_set1_ps(0.25f);
+	const __m256 sign = _mm256_set1_ps(-0.0f);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 8 <= jend; j += 8) {
+			__m256 sum = _mm256_add_ps(_mm256_loadu_ps(&above[j]), _mm256_loadu_ps(&below[j]));
+			sum = _mm256_add_ps(sum, _mm256_loadu_ps(&row[j-1]));
+			sum = _mm256_add_ps(sum, _mm256_loadu_ps(&row[j+1]));
+			_mm256_storeu_ps(&out[j], _mm256_mul_ps(sum, quarter));
+		}
+	} else {
+		__m256 vmax = _mm256_setzero_ps();
+		__m256 vsum_sq = _mm256_setzero_ps();
+		for (; j + 8 <= jend; j += 8) {
+			__m256 sum = _mm256_add_ps(_mm256_loadu_ps(&above[j]), _mm256_loadu_ps(&below[j]));
+			sum = _mm256_add_ps(sum, _mm256_loadu_ps(&row[j-1]));
+			sum = _mm256_add_ps(sum, _mm256_loadu_ps(&row[j+1]));
+			__m256 avg = _mm256_mul_ps(sum, quarter);
+			_mm256_storeu_ps(&out[j], avg);
+
+			__m256 change = _mm256_andnot_ps(sign, _mm256_sub_ps(avg, _mm256_loadu_ps(&row[j])));
+			vmax = _mm256_max_ps(vmax, change);
+			vsum_sq = _mm256_add_ps(vsum_sq, _mm256_mul_ps(change, change));
+		}
+
+		float lanes[8], sums[8];
+		_mm256_storeu_ps(lanes, vmax);
+		_mm256_storeu_ps(sums, vsum_sq);
+		for (int k = 0; k < 8; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row_scalar_f(above, row, below, out, j, jend, res);
+}
+
+__attribute__((target("avx2")))
+static void step_row_avx2(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, double coef, Residual *res) {
+	const __m256d vcoef = _mm256_set1_pd(coef);
+	const __m256d four = _mm256_set1_pd(4.0);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+
+	int j = jbegin;
+	__m256d vmax = _mm256_setzero_pd();
+	__m256d vsum_sq = _mm256_setzero_pd();
+	for (; j + 4 <= jend; j += 4) {
+		__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&above[j]), _mm256_loadu_pd(&below[j]));
+		sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j-1]));
+		sum = _mm256_add_pd(sum, _mm256_loadu_pd(&row[j+1]));
+		__m256d center = _mm256_loadu_pd(&row[j]);
+		__m256d change = _mm256_mul_pd(vcoef, _mm256_sub_pd(sum, _mm256_mul_pd(four, center)));
+		_mm256_storeu_pd(&out[j], _mm256_add_pd(center, change));
+
+		if (res != NULL) {
+			change = _mm256_andnot_pd(sign, change);
+			vmax = _mm256_max_pd(vmax, change);
+			vsum_sq = _mm256_add_pd(vsum_sq, _mm256_mul_pd(change, change));
+		}
+	}
+
+	if (res != NULL) {
+		double lanes[4], sums[4];
+		_mm256_storeu_pd(lanes, vmax);
+		_mm256_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 4; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	step_row_scalar(above, row, below, out, j, jend, coef, res);
+}
+
+__attribute__((target("avx512f")))
+static void step_row_avx512(const double *above, const double *row, const double *below,
+		double *out, int jbegin, int jend, double coef, Residual *res) {
+	const __m512d vcoef = _mm512_set1_pd(coef);
+	const __m512d four = _mm512_set1_pd(4.0);
+
+	int j = jbegin;
+	__m512d vmax = _mm512_setzero_pd();
+	__m512d vsum_sq = _mm512_setzero_pd();
+	for (; j + 8 <= jend; j += 8) {
+		__m512d sum = _mm512_add_pd(_mm512_loadu_pd(&above[j]), _mm512_loadu_pd(&below[j]));
+		sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j-1]));
+		sum = _mm512_add_pd(sum, _mm512_loadu_pd(&row[j+1]));
+		__m512d center = _mm512_loadu_pd(&row[j]);
+		__m512d change = _mm512_mul_pd(vcoef, _mm512_sub_pd(sum, _mm512_mul_pd(four, center)));
+		_mm512_storeu_pd(&out[j], _mm512_add_pd(center, change));
+
+		if (res != NULL) {
+			change = _mm512_abs_pd(change);
+			vmax = _mm512_maskz_max_pd(0xff, vmax, change);
+			vsum_sq = _mm512_add_pd(vsum_sq, _mm512_mul_pd(change, change));
+		}
+	}
+
+	if (res != NULL) {
+		double lanes[8], sums[8];
+		_mm512_storeu_pd(lanes, vmax);
+		_mm512_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 8; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	step_row_scalar(above, row, below, out, j, jend, coef, res);
+}
+
+__attribute__((target("avx2")))
+static void update_row7_avx2(const double *below, const double *front, const double *row,
+		const double *back, const double *above, double *out, int jbegin, int jend,
+		Residual *res) {
+	const __m256d sixth = _mm256_set1_pd(SIXTH);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 4 <= jend; j += 4) {
+			__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&row[j-1]), _mm256_loadu_pd(&row[j+1]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&front[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&back[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&below[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&above[j]));
+			_mm256_storeu_pd(&out[j], _mm256_mul_pd(sum, sixth));
+		}
+	} else {
+		__m256d vmax = _mm256_setzero_pd();
+		__m256d vsum_sq = _mm256_setzero_pd();
+		for (; j + 4 <= jend; j += 4) {
+			__m256d sum = _mm256_add_pd(_mm256_loadu_pd(&row[j-1]), _mm256_loadu_pd(&row[j+1]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&front[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&back[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&below[j]));
+			sum = _mm256_add_pd(sum, _mm256_loadu_pd(&above[j]));
+			__m256d avg = _mm256_mul_pd(sum, sixth);
+			_mm256_storeu_pd(&out[j], avg);
+
+			__m256d change = _mm256_andnot_pd(sign, _mm256_sub_pd(avg, _mm256_loadu_pd(&row[j])));
+			vmax = _mm256_max_pd(vmax, change);
+			vsum_sq = _mm256_add_pd(vsum_sq, _mm256_mul_pd(change, change));
+		}
+
+		double lanes[4], sums[4];
+		_mm256_storeu_pd(lanes, vmax);
+		_mm256_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 4; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row7_scalar(below, front, row, back, above, out, j, jend, res);
+}
+
+__attribute__((target("avx512f")))
+static void update_row7_avx512(const double *below, const double *front, const double *row,
+		const double *back, const double *above, double *out, int jbegin, int jend,
+		Residual *res) {
+	const __m512d sixth = _mm512_set1_pd(SIXTH);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 8 <= jend; j += 8) {
+			__m512d sum = _mm512_add_pd(_mm512_loadu_pd(&row[j-1]), _mm512_loadu_pd(&row[j+1]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&front[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&back[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&below[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&above[j]));
+			_mm512_storeu_pd(&out[j], _mm512_mul_pd(sum, sixth));
+		}
+	} else {
+		__m512d vmax = _mm512_setzero_pd();
+		__m512d vsum_sq = _mm512_setzero_pd();
+		for (; j + 8 <= jend; j += 8) {
+			__m512d sum = _mm512_add_pd(_mm512_loadu_pd(&row[j-1]), _mm512_loadu_pd(&row[j+1]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&front[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&back[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&below[j]));
+			sum = _mm512_add_pd(sum, _mm512_loadu_pd(&above[j]));
+			__m512d avg = _mm512_mul_pd(sum, sixth);
+			_mm512_storeu_pd(&out[j], avg);
+
+			__m512d change = _mm512_abs_pd(_mm512_sub_pd(avg, _mm512_loadu_pd(&row[j])));
+			vmax = _mm512_maskz_max_pd(0xff, vmax, change);
+			vsum_sq = _mm512_add_pd(vsum_sq, _mm512_mul_pd(change, change));
+		}
+
+		double lanes[8], sums[8];
+		_mm512_storeu_pd(lanes, vmax);
+		_mm512_storeu_pd(sums, vsum_sq);
+		for (int k = 0; k < 8; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row7_scalar(below, front, row, back, above, out, j, jend, res);
+}
+
+__attribute__((target("avx512f")))
+static void update_row_avx512_f(const float *above, const float *row, const float *below,
+		float *out, int jbegin, int jend, ResidualF *res) {
+	const __m512 quarter = _mm512_set1_ps(0.25f);
+
+	int j = jbegin;
+	if (res == NULL) {
+		for (; j + 16 <= jend; j += 16) {
+			__m512 sum = _mm512_add_ps(_mm512_loadu_ps(&above[j]), _mm512_loadu_ps(&below[j]));
+			sum = _mm512_add_ps(sum, _mm512_loadu_ps(&row[j-1]));
+			sum = _mm512_add_ps(sum, _mm512_loadu_ps(&row[j+1]));
+			_mm512_storeu_ps(&out[j], _mm512_mul_ps(sum, quarter));
+		}
+	} else {
+		__m512 vmax = _mm512_setzero_ps();
+		__m512 vsum_sq = _mm512_setzero_ps();
+		for (; j + 16 <= jend; j += 16) {
+			__m512 sum = _mm512_add_ps(_mm512_loadu_ps(&above[j]), _mm512_loadu_ps(&below[j]));
+			sum = _mm512_add_ps(sum, _mm512_loadu_ps(&row[j-1]));
+			sum = _mm512_add_ps(sum, _mm512_loadu_ps(&row[j+1]));
+			__m512 avg = _mm512_mul_ps(sum, quarter);
+			_mm512_storeu_ps(&out[j], avg);
+
+			__m512 change = _mm512_abs_ps(_mm512_sub_ps(avg, _mm512_loadu_ps(&row[j])));
+			vmax = _mm512_maskz_max_ps(0xffff, vmax, change);
+			vsum_sq = _mm512_add_ps(vsum_sq, _mm512_mul_ps(change, change));
+		}
+
+		float lanes[16], sums[16];
+		_mm512_storeu_ps(lanes, vmax);
+		_mm512_storeu_ps(sums, vsum_sq);
+		for (int k = 0; k < 16; k++) {
+			if (lanes[k] > res->max) {
+				res->max = lanes[k];
+			}
+			res->sum_sq += sums[k];
+		}
+	}
+	_mm256_zeroupper();
+
+	// leftover cells at the end of the row
+	update_row_scalar_f(above, row, below, out, j, jend, res);
+}
+#endif
+
+// The widest instruction set supported by the CPU we are running on
+int simd_best(void) {
+#ifdef HAVE_X86_SIMD
+	if (__builtin_cpu_supports("avx512f")) {
+		return SIMD_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return SIMD_AVX2;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+// Turn a requested instruction set into one that can actually be used:
+// SIMD_AUTO, or anything wider than the CPU supports, becomes the
+// widest supported one.
+int simd_resolve(int level) {
+	int best = simd_best();
+	if (level == SIMD_AUTO || level > best) {
+		return best;
+	}
+	return level;
+}
+
+const char *simd_name(int level) {
+	switch (level) {
+	case SIMD_AVX2:
+		return "avx2";
+	case SIMD_AVX512:
+		return "avx512";
+	default:
+		return "scalar";
+	}
+}
+
+// Look up an instruction set by name ("auto" for SIMD_AUTO), setting
+// *level to it.
+// Returns false if there is no instruction set with that name.
+bool simd_from_name(const char *name, int *level) {
+	if (strcmp(name, "auto") == 0) {
+		*level = SIMD_AUTO;
+		return true;
+	}
+	for (int l = SIMD_SCALAR; l <= SIMD_AVX512; l++) {
+		if (strcmp(name, simd_name(l)) == 0) {
+			*level = l;
+			return true;
+		}
+	}
+	return false;
+}
+
+template <>
+RowUpdate row_update<double>(int level) {
+	switch (simd_resolve(level)) {
+#ifdef HAVE_X86_SIMD
+	case SIMD_AVX2:
+		return update_row_avx2;
+	case SIMD_AVX512:
+		return update_row_avx512;
+#endif
+	default:
+		return update_row_scalar;
+	}
+}
+
+template <>
+RowUpdateF row_update<float>(int level) {
+	switch (simd_resolve(level)) {
+#ifdef HAVE_X86_SIMD
+	case SIMD_AVX2:
+		return update_row_avx2_f;
+	case SIMD_AVX512:
+		return update_row_avx512_f;
+#endif
+	default:
+		return update_row_scalar_f;
+	}
+}
+
+RowUpdate7 row_update7(int level) {
+	switch (simd_resolve(level)) {
+#ifdef HAVE_X86_SIMD
+	case SIMD_AVX2:
+		return update_row7_avx2;
+	case SIMD_AVX512:
+		return update_row7_avx512;
+#endif
+	default:
+		return update_row7_scalar;
+	}
+}
+
+RowStep row_step(int level) {
+	switch (simd_resolve(level)) {
+#ifdef HAVE_X86_SIMD
+	case SIMD_AVX2:
+		return step_row_avx2;
+	case SIMD_AVX512:
+		return step_row_avx512;
+#endif
+	default:
+		return step_row_scalar;
+	}
+}
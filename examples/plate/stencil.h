@@ -0,0 +1,84 @@
+#ifndef STENCIL_H
+#define STENCIL_H
+
+#include <stddef.h>
+
+// Instruction sets the row update can be compiled for
+enum SimdLevel {
+	SIMD_AUTO = -1,   // use the widest one this CPU supports
+	SIMD_SCALAR = 0,
+	SIMD_AVX2 = 1,
+	SIMD_AVX512 = 2
+};
+
+// How far a sweep is from convergence, measured by how much the cells
+// changed: the largest change of any cell (the max norm) and the sum
+// of the squared changes (whose square root is the L2 norm)
+template <typename T>
+struct ResidualOf {
+	T max;
+	T sum_sq;
+};
+
+typedef ResidualOf<double> Residual;
+typedef ResidualOf<float> ResidualF;
+
+// Update columns jbegin..jend-1 of one interior row: each cell of out
+// becomes the average of its top/bottom/left/right neighbors.  Unless
+// res is NULL, res->max is raised to the largest change of any updated
+// cell and the squared changes are added to res->sum_sq; sweeps whose
+// residual isn't needed pass NULL and skip that work.
+// T is the cell type (double or float).
+template <typename T>
+struct RowKernel {
+	typedef void (*Update)(const T *above, const T *row, const T *below,
+		T *out, int jbegin, int jend, ResidualOf<T> *res);
+};
+
+typedef RowKernel<double>::Update RowUpdate;
+typedef RowKernel<float>::Update RowUpdateF;
+
+void update_row_scalar(const double *above, const double *row, const double *below,
+	double *out, int jbegin, int jend, Residual *res);
+void update_row_scalar_f(const float *above, const float *row, const float *below,
+	float *out, int jbegin, int jend, ResidualF *res);
+
+// One explicit time step of the heat equation for columns
+// jbegin..jend-1 of one interior row: each cell of out becomes
+//
+//   row[j] + coef * (sum of its 4 neighbors - 4 row[j])
+//
+// (see transient.cpp).  res is as above, for the change of each cell.
+typedef void (*RowStep)(const double *above, const double *row, const double *below,
+	double *out, int jbegin, int jend, double coef, Residual *res);
+
+void step_row_scalar(const double *above, const double *row, const double *below,
+	double *out, int jbegin, int jend, double coef, Residual *res);
+
+// The 3D version, for one interior row of a block (see volume.h): each
+// cell of out becomes the average of its six neighbors, the cells on
+// either side of it in row and the cells in the same column of the rows
+// in front of it, behind it, below it and above it.  res is as above.
+typedef void (*RowUpdate7)(const double *below, const double *front, const double *row,
+	const double *back, const double *above, double *out, int jbegin, int jend, Residual *res);
+
+void update_row7_scalar(const double *below, const double *front, const double *row,
+	const double *back, const double *above, double *out, int jbegin, int jend, Residual *res);
+
+int simd_best(void);
+int simd_resolve(int level);
+const char *simd_name(int level);
+bool simd_from_name(const char *name, int *level);
+
+// Row update kernel for cells of type T using the given instruction set
+// (or the widest supported one, see simd_resolve)
+template <typename T>
+typename RowKernel<T>::Update row_update(int level);
+
+template <> RowUpdate row_update<double>(int level);
+template <> RowUpdateF row_update<float>(int level);
+
+RowUpdate7 row_update7(int level);
+RowStep row_step(int level);
+
+#endif // STENCIL_H
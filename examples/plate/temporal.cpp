@@ -0,0 +1,86 @@
+#include "temporal.h"
+
+// Do several Jacobi sweeps in a row, a tile at a time, so that each
+// tile is advanced through all of the sweeps while it is in cache,
+// instead of streaming the whole plate from memory on every sweep.
+//
+// The plate starts in a.  Sweep t reads the buffer holding the
+// temperatures after t sweeps (a if t is even, b if odd) and writes
+// the other one, exactly like steps-many calls to jacobi_sweep with
+// the buffers swapped in between.  So after an even number of steps
+// the answer is in a, and after an odd number it is in b.
+//
+// Tile (bi, bj) covers a tile_rows by tile_cols block of cells, but
+// on sweep t it is moved up and left by 2t cells:
+//
+//   rows 1 + bi*tile_rows - 2t  up to (not incl.) 1 + (bi+1)*tile_rows - 2t
+//   cols 1 + bj*tile_cols - 2t  up to (not incl.) 1 + (bj+1)*tile_cols - 2t
+//
+// (cut off at the edges of the plate).  Tiles are done in row-major
+// order.  With this skew, by the time a tile updates a cell on sweep
+// t, all of that cell's neighbors already have their sweep t-1 values
+// (from this tile or ones above and to the left), and none of the
+// sweep t-2 values this sweep overwrites are still needed by a tile
+// that hasn't run yet.  A skew of 1 would not be enough with only two
+// buffers.  Since every cell is computed from the same neighbor
+// values as in plain sweeps, the temperatures are identical.
+//
+// Unless res is NULL, it is set to the residual of the last sweep; the
+// earlier sweeps don't measure theirs.
+template <typename T>
+void jacobi_sweeps_temporal(GridOf<T> *a, GridOf<T> *b, int steps, int tile_rows, int tile_cols,
+		typename RowKernel<T>::Update update, ResidualOf<T> *res) {
+	int nrows = a->nrows;
+	int ncols = a->ncols;
+
+	// enough tiles to still cover the plate after the last sweep's skew
+	int skew = 2 * (steps-1);
+	int row_tiles = (nrows-2 + skew + tile_rows-1) / tile_rows;
+	int col_tiles = (ncols-2 + skew + tile_cols-1) / tile_cols;
+
+	if (res != NULL) {
+		res->max = 0;
+		res->sum_sq = 0;
+	}
+
+	for (int bi = 0; bi < row_tiles; bi++) {
+		for (int bj = 0; bj < col_tiles; bj++) {
+			for (int t = 0; t < steps; t++) {
+				int row_begin = 1 + bi * tile_rows - 2*t;
+				int row_end = row_begin + tile_rows;
+				int col_begin = 1 + bj * tile_cols - 2*t;
+				int col_end = col_begin + tile_cols;
+
+				if (row_begin < 1) {
+					row_begin = 1;
+				}
+				if (row_end > nrows-1) {
+					row_end = nrows-1;
+				}
+				if (col_begin < 1) {
+					col_begin = 1;
+				}
+				if (col_end > ncols-1) {
+					col_end = ncols-1;
+				}
+				if (row_begin >= row_end || col_begin >= col_end) {
+					continue;
+				}
+
+				const GridOf<T> *cur = (t % 2 == 0) ? a : b;
+				GridOf<T> *next = (t % 2 == 0) ? b : a;
+
+				// only the last sweep's changes count toward the residual
+				ResidualOf<T> *change = (t == steps-1) ? res : NULL;
+
+				for (int i = row_begin; i < row_end; i++) {
+					update(&CELL(cur, i-1, 0), &CELL(cur, i, 0), &CELL(cur, i+1, 0),
+						&CELL(next, i, 0), col_begin, col_end, change);
+				}
+			}
+		}
+	}
+}
+
+template void jacobi_sweeps_temporal(GridF *, GridF *, int, int, int, RowUpdateF, ResidualF *);
+template void jacobi_sweeps_temporal(Grid *, Grid *, int, int, int, RowUpdate, Residual *);
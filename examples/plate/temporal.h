@@ -0,0 +1,17 @@
+#ifndef TEMPORAL_H
+#define TEMPORAL_H
+
+#include "grid.h"
+#include "stencil.h"
+
+// Tile size used for temporal blocking unless one is given.  Together
+// with the skew, two buffers' worth of such a tile stay well within a
+// typical L2 cache.
+#define TEMPORAL_TILE_ROWS 64
+#define TEMPORAL_TILE_COLS 1024
+
+template <typename T>
+void jacobi_sweeps_temporal(GridOf<T> *a, GridOf<T> *b, int steps, int tile_rows, int tile_cols,
+	typename RowKernel<T>::Update update, ResidualOf<T> *res);
+
+#endif // TEMPORAL_H
@@ -0,0 +1,133 @@
+#include <math.h>
+#include "framewriter.h"
+#include "timer.h"
+#include "transient.h"
+
+// The plate's temperatures u evolve by the heat equation
+//
+//   du/dt = alpha (d^2u/dx^2 + d^2u/dy^2)
+//
+// with the edge cells held at their temperatures.  An explicit (forward
+// Euler) step with the 5-point Laplacian is
+//
+//   u'[i][j] = u[i][j] + c (sum of the 4 neighbors - 4 u[i][j]),
+//
+// where c = alpha dt / h^2 and the cell spacing h is 1.  Errors grow
+// without bound unless c <= 1/4, which limits dt.  With c = 1/4 the
+// step is a Jacobi sweep, so the steady state the steps head for is
+// the one plate.exe solves for.  The steps use vectorized row kernels
+// like the sweeps (see RowStep in stencil.h).
+
+// Largest stable time step for a diffusivity
+double heat_max_dt(double alpha) {
+	return HEAT_MAX_COEF / alpha;
+}
+
+// Take one explicit time step from cur into next, with c = coef, for
+// every interior cell (or the cells of the mask, if not NULL).  The
+// other cells of next are not touched, so they must already hold the
+// fixed temperatures.  Unless res is NULL, it is set to the largest
+// change of a cell and the sum of the squared changes.
+void heat_step(const Grid *cur, Grid *next, double coef, const Mask *mask, RowStep step,
+		Residual *res) {
+	if (res != NULL) {
+		res->max = 0.0;
+		res->sum_sq = 0.0;
+	}
+
+	if (mask != NULL) {
+		for (int k = 0; k < mask->nspans; k++) {
+			const Span *s = &mask->spans[k];
+			step(&CELL(cur, s->row-1, 0), &CELL(cur, s->row, 0), &CELL(cur, s->row+1, 0),
+				&CELL(next, s->row, 0), s->jbegin, s->jend, coef, res);
+		}
+		return;
+	}
+
+	for (int i = 1; i < cur->nrows-1; i++) {
+		step(&CELL(cur, i-1, 0), &CELL(cur, i, 0), &CELL(cur, i+1, 0),
+			&CELL(next, i, 0), 1, cur->ncols-1, coef, res);
+	}
+}
+
+// Take params->steps explicit time steps of size params->dt on the
+// plate, which starts at step first_step (when a run was restarted).
+// At every step that is a multiple of params->frame_every, counting
+// from step 0 so that a restarted run keeps the same schedule, a frame
+// is handed to a FrameWriter, which saves it on its own thread while
+// the steps go on.  The initial temperatures are a frame if first_step
+// is on the schedule.  The caller must
+// have checked that the time step is stable.  When done, plate holds
+// the final temperatures.
+// Returns false if memory could not be allocated, the writer could not
+// be started, or a frame could not be written (after printing why).
+bool heat_run(Grid *plate, const HeatParams *params, long first_step, HeatResult *result) {
+	double coef = params->alpha * params->dt;
+	RowStep step = row_step(params->simd);
+	bool frames = params->frame_every > 0;
+
+	Grid next;
+	if (!grid_alloc(&next, plate->nrows, plate->ncols)) {
+		return false;
+	}
+	grid_copy(&next, plate);
+
+	FrameWriter writer;
+	if (frames && !frame_writer_start(&writer, params->frame_prefix, plate->nrows, plate->ncols)) {
+		grid_free(&next);
+		return false;
+	}
+
+	result->step_seconds = 0.0;
+	result->copy_seconds = 0.0;
+	result->residual = 0.0;
+	result->residual_l2 = 0.0;
+
+	double start = wall_time();
+	if (frames && first_step % params->frame_every == 0) {
+		frame_writer_submit(&writer, plate, first_step, 0.0);
+		result->copy_seconds += wall_time() - start;
+	}
+
+	for (long n = 1; n <= params->steps; n++) {
+		// the change is only measured for steps that are saved or reported
+		bool frame_due = frames && (first_step + n) % params->frame_every == 0;
+		Residual res;
+		bool measure = frame_due || n == params->steps;
+
+		double t0 = wall_time();
+		heat_step(plate, &next, coef, params->mask, step, measure ? &res : NULL);
+		grid_swap(plate, &next);
+		double t1 = wall_time();
+		result->step_seconds += t1 - t0;
+
+		if (measure) {
+			result->residual = res.max;
+			result->residual_l2 = sqrt(res.sum_sq);
+		}
+		if (frame_due) {
+			frame_writer_submit(&writer, plate, first_step + n, res.max);
+			result->copy_seconds += wall_time() - t1;
+		}
+	}
+
+	bool ok = true;
+	result->frames = 0;
+	result->write_seconds = 0.0;
+	result->wait_seconds = 0.0;
+	result->drain_seconds = 0.0;
+	if (frames) {
+		ok = frame_writer_finish(&writer);
+		result->frames = writer.frames;
+		result->write_seconds = writer.write_seconds;
+		result->wait_seconds = writer.wait_seconds;
+		result->drain_seconds = writer.drain_seconds;
+		// the waits were counted as copying above
+		result->copy_seconds -= writer.wait_seconds;
+	}
+	result->seconds = wall_time() - start;
+	result->steps = params->steps;
+
+	grid_free(&next);
+	return ok;
+}
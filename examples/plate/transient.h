@@ -0,0 +1,42 @@
+#ifndef TRANSIENT_H
+#define TRANSIENT_H
+
+#include "grid.h"
+#include "mask.h"
+#include "stencil.h"
+
+// Explicit time steps are only stable while alpha * dt / h^2 is at
+// most this (for the 5-point stencil in 2D, with cell spacing h = 1)
+#define HEAT_MAX_COEF 0.25
+
+// Setup for a transient (time-stepping) run
+struct HeatParams {
+	double alpha;               // thermal diffusivity, in cells^2 per unit time
+	double dt;                  // time step
+	long steps;                 // number of time steps to take
+	int frame_every;            // save a frame every this many steps (0 = none)
+	const char *frame_prefix;   // frames go to PREFIX<step>.bin
+	const Mask *mask;           // cells to step (NULL = the whole interior)
+	int simd;                   // instruction set for the steps (a SimdLevel)
+};
+
+// What a transient run did
+struct HeatResult {
+	long steps;
+	double residual;            // largest change of a cell in the last step
+	double residual_l2;         // L2 norm of the changes in the last step
+	double seconds;             // whole run, including waiting for the writer
+	double step_seconds;        // time spent stepping
+	double copy_seconds;        // time spent copying frames for the writer
+	int frames;
+	double write_seconds;       // time the writer thread spent writing
+	double wait_seconds;        // time the steps waited for a free frame buffer
+	double drain_seconds;       // time waiting for the last frames at the end
+};
+
+double heat_max_dt(double alpha);
+void heat_step(const Grid *cur, Grid *next, double coef, const Mask *mask, RowStep step,
+	Residual *res);
+bool heat_run(Grid *plate, const HeatParams *params, long first_step, HeatResult *result);
+
+#endif // TRANSIENT_H
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "volume.h"
+
+// Allocate storage for an nx by ny by nz block.
+// Returns false if the memory could not be allocated.
+bool volume_alloc(Volume *v, int nx, int ny, int nz) {
+	v->nx = nx;
+	v->ny = ny;
+	v->nz = nz;
+	v->cells = (double *) malloc((size_t) nx * ny * nz * sizeof(double));
+	return v->cells != NULL;
+}
+
+void volume_free(Volume *v) {
+	free(v->cells);
+	v->cells = NULL;
+}
+
+// Copy all cells of src into dst (which must have the same size)
+void volume_copy(Volume *dst, const Volume *src) {
+	memcpy(dst->cells, src->cells, (size_t) src->nx * src->ny * src->nz * sizeof(double));
+}
+
+// Exchange the cell storage of two blocks of the same size
+void volume_swap(Volume *a, Volume *b) {
+	double *tmp = a->cells;
+	a->cells = b->cells;
+	b->cells = tmp;
+}
+
+// Set the fixed face temperatures, and set all interior cells to 0.
+// Where two faces meet, the one later in Faces wins; those edge cells
+// are not neighbors of any interior cell, so it doesn't matter which.
+void volume_init(Volume *v, const Faces *faces) {
+	for (int z = 0; z < v->nz; z++) {
+		for (int y = 0; y < v->ny; y++) {
+			for (int x = 0; x < v->nx; x++) {
+				double t = 0.0;
+				if (x == 0) {
+					t = faces->left;
+				}
+				if (x == v->nx-1) {
+					t = faces->right;
+				}
+				if (y == 0) {
+					t = faces->front;
+				}
+				if (y == v->ny-1) {
+					t = faces->back;
+				}
+				if (z == 0) {
+					t = faces->bottom;
+				}
+				if (z == v->nz-1) {
+					t = faces->top;
+				}
+				VCELL(v, x, y, z) = t;
+			}
+		}
+	}
+}
+
+// Print one layer of the block, as a table like grid_print
+void volume_print_layer(const Volume *v, int z) {
+	for (int y = 0; y < v->ny; y++) {
+		for (int x = 0; x < v->nx; x++) {
+			printf("%6.1lf ", VCELL(v, x, y, z));
+		}
+		printf("\n");
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include <stddef.h>
+
+// A rectangular block of temperatures, nx by ny by nz cells.  The
+// cells are stored in one heap-allocated array, layer by layer (z),
+// and each layer row by row (y), so that neighbors in x are next to
+// each other in memory, as in a Grid.
+struct Volume {
+	int nx;
+	int ny;
+	int nz;
+	double *cells;
+};
+
+// Cell at column x, row y, layer z
+#define VCELL(v, x, y, z) ((v)->cells[((size_t)(z) * (v)->ny + (y)) * (v)->nx + (x)])
+
+// Fixed temperatures of the six faces of a block
+struct Faces {
+	double left;      // x = 0
+	double right;     // x = nx-1
+	double front;     // y = 0
+	double back;      // y = ny-1
+	double bottom;    // z = 0
+	double top;       // z = nz-1
+};
+
+bool volume_alloc(Volume *v, int nx, int ny, int nz);
+void volume_free(Volume *v);
+void volume_copy(Volume *dst, const Volume *src);
+void volume_swap(Volume *a, Volume *b);
+void volume_init(Volume *v, const Faces *faces);
+void volume_print_layer(const Volume *v, int z);
+
+#endif // VOLUME_H
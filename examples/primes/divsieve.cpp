@@ -0,0 +1,310 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "divsieve.h"
+#include "sieve.h"
+
+// A sieve for the divisor functions sigma(n) (the sum of the divisors
+// of n) and d(n) (how many there are).  Both are multiplicative: for
+// n = p1^e1 ... pk^ek,
+//
+//   sigma(n) = (1 + p1 + ... + p1^e1) ... (1 + pk + ... + pk^ek)
+//   d(n) = (e1 + 1) ... (ek + 1)
+//
+// So instead of trying divisors of each number, the sieve goes through
+// the primes, and multiplies the numbers that are multiples of each
+// prime by its factor.  Like the prime sieve (see sieve.cpp), it works
+// on one cache-sized segment of the range at a time, with the primes
+// up to the square root of the end of the range.  For each prime p:
+//
+//  - the multiples of p^2, p^3, ... each get 1 added to a counter, so
+//    that for a multiple of p the counter is then e - 1, where p^e is
+//    the power of p in it
+//  - the multiples of p have sigma multiplied by 1 + p + ... + p^e and
+//    d by e + 1, both from a small table, and the counter is reset
+//
+// which is N/p + N/p^2 + ... steps, and N log log N for all of them,
+// with no divisions.  (2 is quicker still: the power of 2 in a number
+// is its count of trailing zero bits.)  The product of the prime
+// powers found is kept too: a number can have one prime factor bigger
+// than the square root of the end of the range, and dividing by that
+// product at the end gives it.
+//
+// Everything kept for a number is in one struct, so that a step only
+// touches one cache line; with separate arrays, the steps for the
+// larger primes, which skip far ahead each time, touched three, and
+// took twice as long.  The segments are independent, and shared out
+// among threads as in the prime sieve.
+
+void divisor_params_init(DivisorParams *params) {
+	params->nthreads = 1;
+	params->segment_size = DIVSIEVE_SEGMENT;
+	params->callback = NULL;
+	params->arg = NULL;
+}
+
+// State shared by the threads sieving one range
+struct DivShared {
+	uint64_t lo;
+	uint64_t hi;
+	size_t segment_size;
+	uint64_t nsegments;
+	const uint32_t *base;     // the primes up to the square root of hi - 1
+	size_t nbase;
+	const DivisorParams *params;
+
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+	uint64_t next_segment;    // next segment for a thread to take
+	uint64_t delivered;       // segments passed to the callback so far
+};
+
+// What the sieve keeps for a number while it works on a segment
+struct DivisorState {
+	uint64_t sigma;           // sigma of the prime powers found so far
+	uint64_t product;         // product of the prime powers found so far
+	uint32_t ndivisors;       // d of them, in the low 24 bits (d(n) is far
+	                          // smaller for any n up to 2^53), and the
+	                          // counter for the current prime in the top 8
+};
+
+#define COUNTER_SHIFT 24
+#define NDIVISORS_MASK ((1u << COUNTER_SHIFT) - 1)
+
+// One thread's arrays, one entry per number of a segment, and its counts
+struct DivWorker {
+	pthread_t thread;
+	DivShared *shared;
+	DivisorState *state;
+	uint64_t *sigma;          // the results, for the callback
+	uint32_t *ndivisors;
+	DivisorCounts counts;
+};
+
+// The first multiple of q that is at least n
+static inline uint64_t first_multiple(uint64_t q, uint64_t n) {
+	return (n + q - 1) / q * q;
+}
+
+// Compute sigma and d for the numbers first..first+count-1 into the
+// worker's arrays.
+static void sieve_segment(const DivShared *shared, uint64_t first, size_t count,
+		DivWorker *w) {
+	DivisorState *state = w->state;
+
+	// the power of 2 in each number is just its trailing zero bits
+	for (size_t i = 0; i < count; i++) {
+		int e = __builtin_ctzll(first + i);
+		state[i].sigma = (2ULL << e) - 1;
+		state[i].product = 1ULL << e;
+		state[i].ndivisors = e + 1;
+	}
+
+	// and the odd primes are sieved (base[0] is 2)
+	uint64_t last = first + count - 1;
+	for (size_t k = 1; k < shared->nbase; k++) {
+		uint64_t p = shared->base[k];
+		if (p * p > last) {
+			break;
+		}
+
+		// count the powers past p, up to the highest one that fits
+		int top = 1;
+		for (uint64_t q = p; q <= last / p; ) {
+			q *= p;
+			top++;
+			for (uint64_t m = first_multiple(q, first); m <= last; m += q) {
+				state[m - first].ndivisors += 1u << COUNTER_SHIFT;
+			}
+		}
+
+		// p^e and 1 + p + ... + p^e
+		uint64_t power[64], sum[64];
+		power[0] = 1;
+		sum[0] = 1;
+		for (int e = 1; e <= top; e++) {
+			power[e] = power[e-1] * p;
+			sum[e] = sum[e-1] + power[e];
+		}
+
+		for (uint64_t m = first_multiple(p, first); m <= last; m += p) {
+			DivisorState *s = &state[m - first];
+			uint32_t e = 1 + (s->ndivisors >> COUNTER_SHIFT);
+			s->sigma *= sum[e];
+			s->product *= power[e];
+			s->ndivisors = (s->ndivisors & NDIVISORS_MASK) * (e + 1);
+		}
+	}
+
+	// What is left of each number after its prime powers up to the
+	// square root of last is 1 or a prime.  The division is exact, so
+	// double precision gets it right for numbers up to 2^53, and is
+	// much faster than integer division.  Whether there is a prime left
+	// is about as likely as not, so it is worked in without branching.
+	for (size_t i = 0; i < count; i++) {
+		uint64_t rest = (uint64_t) ((double) (first + i) / (double) state[i].product);
+		uint64_t prime = rest > 1;
+		w->sigma[i] = state[i].sigma * (rest + prime);
+		w->ndivisors[i] = state[i].ndivisors << prime;
+	}
+}
+
+// Add the classes of the numbers of a sieved segment to counts
+static void count_classes(const uint64_t *sigma, uint64_t first, size_t count,
+		DivisorCounts *counts) {
+	uint64_t deficient = 0, perfect = 0;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t twice = 2 * (first + i);
+		deficient += sigma[i] < twice;
+		perfect += sigma[i] == twice;
+	}
+	counts->deficient += deficient;
+	counts->perfect += perfect;
+	counts->abundant += count - deficient - perfect;
+}
+
+// Each thread takes the next segment until there are none left, and
+// with a callback, waits for its turn to pass it on, as in the prime
+// sieve.
+static void *worker_main(void *arg) {
+	DivWorker *worker = (DivWorker *) arg;
+	DivShared *shared = worker->shared;
+	const DivisorParams *params = shared->params;
+
+	for (;;) {
+		pthread_mutex_lock(&shared->lock);
+		uint64_t s = shared->next_segment++;
+		pthread_mutex_unlock(&shared->lock);
+		if (s >= shared->nsegments) {
+			break;
+		}
+
+		uint64_t first = shared->lo + s * shared->segment_size;
+		size_t count = shared->segment_size;
+		if (count > shared->hi - first) {
+			count = shared->hi - first;
+		}
+		sieve_segment(shared, first, count, worker);
+		count_classes(worker->sigma, first, count, &worker->counts);
+
+		if (params->callback == NULL) {
+			continue;
+		}
+
+		pthread_mutex_lock(&shared->lock);
+		while (shared->delivered != s) {
+			pthread_cond_wait(&shared->turn, &shared->lock);
+		}
+		pthread_mutex_unlock(&shared->lock);
+
+		DivisorSegment segment;
+		segment.first = first;
+		segment.count = count;
+		segment.sigma = worker->sigma;
+		segment.ndivisors = worker->ndivisors;
+		params->callback(&segment, params->arg);
+
+		pthread_mutex_lock(&shared->lock);
+		shared->delivered++;
+		pthread_cond_broadcast(&shared->turn);
+		pthread_mutex_unlock(&shared->lock);
+	}
+	return NULL;
+}
+
+// Compute sigma(n) and d(n) for every n in lo..hi-1, with
+// params->nthreads threads each sieving segments of
+// params->segment_size numbers.  The segments are passed to
+// params->callback in order, unless it is NULL, and counts is set to
+// how many of the numbers are deficient, perfect and abundant.  lo
+// must be at least 1 and hi at most DIVSIEVE_MAX.
+// Returns false if memory could not be allocated (if a thread could
+// not be started, the others do its share).
+bool divisor_sieve(uint64_t lo, uint64_t hi, const DivisorParams *params,
+		DivisorCounts *counts) {
+	counts->deficient = 0;
+	counts->perfect = 0;
+	counts->abundant = 0;
+	if (hi <= lo) {
+		return true;
+	}
+
+	DivShared shared;
+	shared.lo = lo;
+	shared.hi = hi;
+	shared.params = params;
+	shared.segment_size = params->segment_size;
+	shared.nsegments = (hi - lo + shared.segment_size - 1) / shared.segment_size;
+	shared.next_segment = 0;
+	shared.delivered = 0;
+
+	// the primes up to the square root of hi - 1
+	uint32_t root = (uint32_t) sqrtl((long double) (hi - 1));
+	while ((uint64_t) root * root > hi - 1) {
+		root--;
+	}
+	while ((uint64_t) (root + 1) * (root + 1) <= hi - 1) {
+		root++;
+	}
+	size_t nbase;
+	uint32_t *base = small_primes(root, &nbase);
+	if (base == NULL) {
+		return false;
+	}
+	shared.base = base;
+	shared.nbase = nbase;
+
+	int nthreads = params->nthreads;
+	if ((uint64_t) nthreads > shared.nsegments) {
+		nthreads = (int) shared.nsegments;
+	}
+
+	size_t n = shared.segment_size;
+	DivWorker *workers = (DivWorker *) calloc(nthreads, sizeof(DivWorker));
+	bool ok = workers != NULL;
+	for (int t = 0; t < nthreads && ok; t++) {
+		workers[t].shared = &shared;
+		workers[t].state = (DivisorState *) malloc(n * sizeof(DivisorState));
+		workers[t].sigma = (uint64_t *) malloc(n * sizeof(uint64_t));
+		workers[t].ndivisors = (uint32_t *) malloc(n * sizeof(uint32_t));
+		ok = workers[t].state != NULL && workers[t].sigma != NULL
+			&& workers[t].ndivisors != NULL;
+	}
+
+	if (ok) {
+		pthread_mutex_init(&shared.lock, NULL);
+		pthread_cond_init(&shared.turn, NULL);
+
+		int started = 0;
+		for (int t = 1; t < nthreads; t++) {
+			if (pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]) != 0) {
+				break;
+			}
+			started++;
+		}
+		// the calling thread is worker 0
+		worker_main(&workers[0]);
+		for (int t = 1; t <= started; t++) {
+			pthread_join(workers[t].thread, NULL);
+		}
+
+		for (int t = 0; t < nthreads; t++) {
+			counts->deficient += workers[t].counts.deficient;
+			counts->perfect += workers[t].counts.perfect;
+			counts->abundant += workers[t].counts.abundant;
+		}
+		pthread_mutex_destroy(&shared.lock);
+		pthread_cond_destroy(&shared.turn);
+	}
+
+	if (workers != NULL) {
+		for (int t = 0; t < nthreads; t++) {
+			free(workers[t].state);
+			free(workers[t].sigma);
+			free(workers[t].ndivisors);
+		}
+	}
+	free(workers);
+	free(base);
+	return ok;
+}
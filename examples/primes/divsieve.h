@@ -0,0 +1,52 @@
+#ifndef DIVSIEVE_H
+#define DIVSIEVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Numbers per segment unless a size is given.  The sieve keeps 36
+// bytes per number, so 32768 numbers take about as much as a typical
+// L2 cache holds.
+#define DIVSIEVE_SEGMENT 32768
+
+// Largest end of a range that can be sieved (leftover prime factors
+// are found by dividing in double precision, which is exact up to
+// 2^53)
+#define DIVSIEVE_MAX (1ULL << 53)
+
+// The divisor functions of the numbers first..first+count-1:
+// sigma[i] is the sum of all of the divisors of first+i (the number
+// itself included), and ndivisors[i] how many there are
+struct DivisorSegment {
+	uint64_t first;
+	size_t count;
+	const uint64_t *sigma;
+	const uint32_t *ndivisors;
+};
+
+// Called with the divisor functions of one segment.  The segments
+// are passed in order, one call at a time, as with a PrimeCallback.
+typedef void (*DivisorCallback)(const DivisorSegment *segment, void *arg);
+
+// How to run a divisor sieve
+struct DivisorParams {
+	int nthreads;
+	size_t segment_size;        // numbers per segment
+	DivisorCallback callback;   // NULL to only count the classes
+	void *arg;                  // passed to callback
+};
+
+// How many numbers of each kind a range has: a number n is perfect if
+// the sum of its divisors other than n is n (sigma(n) = 2n), abundant
+// if it is more, and deficient if it is less
+struct DivisorCounts {
+	uint64_t deficient;
+	uint64_t perfect;
+	uint64_t abundant;
+};
+
+void divisor_params_init(DivisorParams *params);
+bool divisor_sieve(uint64_t lo, uint64_t hi, const DivisorParams *params,
+	DivisorCounts *counts);
+
+#endif // DIVSIEVE_H
@@ -0,0 +1,226 @@
+#include <stdlib.h>
+#include "factor.h"
+#include "montgomery.h"
+#include "primality.h"
+
+// Numbers in the factoring sequence between the gcd checks (see
+// brent_rho)
+#define RHO_BATCH 128
+
+// Greatest common divisor, by Stein's binary method (no divisions)
+static uint64_t gcd(uint64_t a, uint64_t b) {
+	if (a == 0) {
+		return b;
+	}
+	if (b == 0) {
+		return a;
+	}
+	int shift = __builtin_ctzll(a | b);
+	a >>= __builtin_ctzll(a);
+	while (b != 0) {
+		b >>= __builtin_ctzll(b);
+		if (a > b) {
+			uint64_t t = a;
+			a = b;
+			b = t;
+		}
+		b -= a;
+	}
+	return a << shift;
+}
+
+// |a - b|, for two numbers in Montgomery form
+static inline uint64_t distance(uint64_t a, uint64_t b) {
+	return (a > b) ? a - b : b - a;
+}
+
+// A factor of n other than 1 and n, by Brent's version of Pollard's rho
+// method.  n must be odd and composite.
+//
+// The sequence y -> y^2 + c mod n is pseudo-random, so modulo an unknown
+// prime factor p of n it repeats after about sqrt(p) steps, and then
+// y - x is a multiple of p for two numbers x and y of the sequence.
+// Brent's cycle finding keeps x at the last power-of-2 position and
+// compares the next r numbers with it, doubling r each round.  The
+// differences are multiplied together (mod n), and the gcd with n,
+// which is the slow part, is only taken every RHO_BATCH steps.  If a
+// batch overshoots and the product becomes a multiple of n, the batch
+// is stepped through again one gcd at a time.  If that finds n itself
+// (the sequence cycled modulo every factor at once), it starts over
+// with another c.  The arithmetic is all in Montgomery form, which
+// doesn't change the gcds, since R is coprime to n.
+static uint64_t brent_rho(uint64_t n) {
+	Montgomery m;
+	montgomery_init(&m, n);
+
+	for (uint64_t c = 1; ; c++) {
+		uint64_t add = montgomery_to(&m, c);
+		uint64_t y = montgomery_to(&m, 2);
+		uint64_t x = y, saved = y;
+		uint64_t product = m.one;
+		uint64_t g = 1;
+
+		for (uint64_t r = 1; g == 1; r *= 2) {
+			x = y;
+			for (uint64_t i = 0; i < r; i++) {
+				y = montgomery_add(&m, montgomery_mul(&m, y, y), add);
+			}
+			for (uint64_t k = 0; k < r && g == 1; k += RHO_BATCH) {
+				saved = y;
+				uint64_t steps = (r - k < RHO_BATCH) ? r - k : RHO_BATCH;
+				for (uint64_t i = 0; i < steps; i++) {
+					y = montgomery_add(&m, montgomery_mul(&m, y, y), add);
+					product = montgomery_mul(&m, product, distance(x, y));
+				}
+				g = gcd(product, n);
+			}
+		}
+
+		if (g == n) {
+			do {
+				saved = montgomery_add(&m, montgomery_mul(&m, saved, saved), add);
+				g = gcd(distance(x, saved), n);
+			} while (g == 1);
+		}
+		if (g != n) {
+			return g;
+		}
+	}
+}
+
+// Add p to the prime factors in f, keeping them in increasing order
+static void add_prime(Factorization *f, uint64_t p, int exponent) {
+	int i = 0;
+	while (i < f->count && f->prime[i] < p) {
+		i++;
+	}
+	if (i < f->count && f->prime[i] == p) {
+		f->exponent[i] += exponent;
+		return;
+	}
+	for (int j = f->count; j > i; j--) {
+		f->prime[j] = f->prime[j-1];
+		f->exponent[j] = f->exponent[j-1];
+	}
+	f->prime[i] = p;
+	f->exponent[i] = exponent;
+	f->count++;
+}
+
+// The prime factorization of n, which must be at least 1 (1 has no
+// prime factors).  Small primes (up to 53) are divided out first, by
+// trial division.  Whatever is left has only large prime factors; each
+// part that is not prime (by the exact Miller-Rabin test) is split in
+// two with Pollard's rho method, until only primes are left.  Finding
+// a prime factor p takes around sqrt(p) steps, so the hardest 64-bit
+// numbers, products of two primes of about 32 bits, take around 2^16
+// steps, or a few milliseconds, where trial division would need up
+// to 2^32 divisions.
+void factorize(uint64_t n, Factorization *f) {
+	f->count = 0;
+	if (n <= 1) {
+		return;
+	}
+
+	uint64_t p;
+	while ((p = small_factor(n)) != 0) {
+		int exponent = 0;
+		do {
+			n /= p;
+			exponent++;
+		} while (n % p == 0);
+		add_prime(f, p, exponent);
+		if (n == 1) {
+			return;
+		}
+	}
+
+	// parts still to be split (a 64-bit number has at most 64 factors)
+	uint64_t stack[64];
+	int top = 0;
+	stack[top++] = n;
+	while (top > 0) {
+		n = stack[--top];
+		if (is_prime(n)) {
+			add_prime(f, n, 1);
+		} else {
+			uint64_t d = brent_rho(n);
+			stack[top++] = d;
+			stack[top++] = n / d;
+		}
+	}
+}
+
+// Number of divisors of the number whose factorization is f (1 and the
+// number itself included)
+uint64_t divisor_count(const Factorization *f) {
+	uint64_t count = 1;
+	for (int i = 0; i < f->count; i++) {
+		count *= f->exponent[i] + 1;
+	}
+	return count;
+}
+
+// Merge the sorted runs a[0..mid-1] and a[mid..end-1] into out
+static void merge(const uint64_t *a, size_t mid, size_t end, uint64_t *out) {
+	size_t i = 0, j = mid, k = 0;
+	while (i < mid && j < end) {
+		out[k++] = (a[i] <= a[j]) ? a[i++] : a[j++];
+	}
+	while (i < mid) {
+		out[k++] = a[i++];
+	}
+	while (j < end) {
+		out[k++] = a[j++];
+	}
+}
+
+// All of the divisors of the number whose factorization is f, 1 and
+// the number itself included, in increasing order, in a new array
+// (which the caller must free), or NULL if there isn't enough memory.
+// *count is set to the number of them.
+//
+// The divisors are built up one prime at a time: if D is the sorted
+// list of divisors so far and p^e the next prime power, the new list
+// is D, p D, p^2 D, ..., p^e D, which are e+1 sorted runs, and merging
+// them pairwise (as in a bottom-up merge sort starting from runs of
+// length |D|) sorts it in log2(e+1) passes.  The lists grow by a
+// factor of at least 2 for each prime, so the total work is a small
+// multiple of the number of divisors, and nothing is ever divided.
+uint64_t *list_divisors(const Factorization *f, size_t *count) {
+	size_t total = divisor_count(f);
+	uint64_t *divisors = (uint64_t *) malloc(total * sizeof(uint64_t));
+	uint64_t *scratch = (uint64_t *) malloc(total * sizeof(uint64_t));
+	if (divisors == NULL || scratch == NULL) {
+		free(divisors);
+		free(scratch);
+		return NULL;
+	}
+
+	size_t len = 1;
+	divisors[0] = 1;
+	for (int i = 0; i < f->count; i++) {
+		size_t run = len;
+		for (int e = 0; e < f->exponent[i]; e++) {
+			for (size_t k = 0; k < run; k++) {
+				divisors[len + k] = divisors[len - run + k] * f->prime[i];
+			}
+			len += run;
+		}
+
+		for (; run < len; run *= 2) {
+			for (size_t start = 0; start < len; start += 2 * run) {
+				size_t mid = (start + run < len) ? run : len - start;
+				size_t end = (start + 2 * run < len) ? 2 * run : len - start;
+				merge(divisors + start, mid, end, scratch + start);
+			}
+			uint64_t *t = divisors;
+			divisors = scratch;
+			scratch = t;
+		}
+	}
+
+	free(scratch);
+	*count = len;
+	return divisors;
+}
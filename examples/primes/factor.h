@@ -0,0 +1,23 @@
+#ifndef FACTOR_H
+#define FACTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Most distinct primes a 64-bit number can have (the product of the
+// first 16 primes is more than 2^64)
+#define MAX_PRIME_FACTORS 15
+
+// n = prime[0]^exponent[0] ... prime[count-1]^exponent[count-1], with
+// the primes in increasing order
+struct Factorization {
+	int count;
+	uint64_t prime[MAX_PRIME_FACTORS];
+	int exponent[MAX_PRIME_FACTORS];
+};
+
+void factorize(uint64_t n, Factorization *f);
+uint64_t divisor_count(const Factorization *f);
+uint64_t *list_divisors(const Factorization *f, size_t *count);
+
+#endif // FACTOR_H
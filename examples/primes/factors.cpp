@@ -0,0 +1,252 @@
+// List the factors of a number, for any number up to 2^64-1.
+//
+//   factors.exe [-p] [-t TABLE] [N]
+//   factors.exe -b [-c] [-t TABLE] < FILE
+//
+// Prints what the classroom programs in s17 print, for much larger
+// numbers.  By default, like s17/factors.cpp, each factor other than 1
+// and N, from the largest down:
+//
+//   ./factors.exe 12
+//   6 is a factor of 12
+//   4 is a factor of 12
+//   ...
+//
+// With -p, like s17/prime-or-factors.cpp, the factors in increasing
+// order and how many there are, or that N is prime.  Without N on the
+// command line, it is asked for, as in those programs.
+//
+// Those programs try every possible factor, which takes seconds for a
+// ten-digit number and years for a twenty-digit one.  This finds the
+// prime factorization (see factor.cpp) and builds the factors from it,
+// so it takes milliseconds at most.
+//
+// -b factors every number on standard input instead, printing each
+// one's prime factors, like "12: 2 2 3", or with -c only the time it
+// took.  -t TABLE looks the factors of numbers up in a table made by
+// spftable.exe, for numbers the table covers; the table is mapped into
+// memory rather than read, so using it costs nothing up front.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "factor.h"
+#include "numread.h"
+#include "numwrite.h"
+#include "spf.h"
+#include "timer.h"
+
+int list_factors(const SpfTable *table, const char *number, bool prime_or_factors);
+int factor_stdin(const SpfTable *table, bool count_only);
+void factor_number(const SpfTable *table, uint64_t n, Factorization *f);
+bool parse_scanf_int(const char *text, uint64_t *n);
+bool read_number(const char *prompt, uint64_t *n);
+void usage(void);
+
+int main(int argc, char *argv[]) {
+	bool prime_or_factors = false;
+	bool batch = false;
+	bool count_only = false;
+	const char *table_file = NULL;
+	const char *number = NULL;
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-p") == 0) {
+			prime_or_factors = true;
+		} else if (strcmp(argv[i], "-b") == 0) {
+			batch = true;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			count_only = true;
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			table_file = argv[++i];
+		} else if (argv[i][0] != '-' && number == NULL) {
+			number = argv[i];
+		} else {
+			usage();
+			return 1;
+		}
+	}
+	if (batch ? (prime_or_factors || number != NULL) : count_only) {
+		usage();
+		return 1;
+	}
+
+	SpfTable table;
+	if (table_file != NULL && !spf_open(&table, table_file)) {
+		return 1;
+	}
+	const SpfTable *use_table = (table_file != NULL) ? &table : NULL;
+
+	int status = batch ? factor_stdin(use_table, count_only)
+		: list_factors(use_table, number, prime_or_factors);
+
+	if (table_file != NULL) {
+		spf_close(&table);
+	}
+	return status;
+}
+
+// Print the factors of number (or of a number asked for, if it is
+// NULL), in the format of s17/factors.cpp or, if prime_or_factors, of
+// s17/prime-or-factors.cpp.
+// Returns the exit status: 1 if there was no number, or not enough
+// memory.
+int list_factors(const SpfTable *table, const char *number, bool prime_or_factors) {
+	uint64_t n;
+	if (number != NULL) {
+		if (!parse_scanf_int(number, &n)) {
+			printf("%s is not a whole number\n", number);
+			return 1;
+		}
+		if (prime_or_factors && n < 2) {
+			printf("%s is less than 2\n", number);
+			return 1;
+		}
+	} else if (!prime_or_factors) {
+		if (!read_number("Enter an integer: ", &n)) {
+			return 1;
+		}
+	} else {
+		// as in prime-or-factors.cpp, keep asking until n >= 2
+		n = 1;
+		while (n < 2) {
+			if (!read_number("Enter an integer (>= 2): ", &n)) {
+				return 1;
+			}
+		}
+	}
+
+	Factorization f;
+	factor_number(table, n, &f);
+	size_t count;
+	uint64_t *divisors = list_divisors(&f, &count);
+	if (divisors == NULL) {
+		printf("Not enough memory for the factors of %llu\n", (unsigned long long) n);
+		return 1;
+	}
+	// divisors[0] is 1 and divisors[count-1] is n (for n >= 1), and
+	// neither is listed
+	unsigned long long un = n;
+
+	if (!prime_or_factors) {
+		for (size_t k = count-1; k > 1; k--) {
+			printf("%llu is a factor of %llu\n", (unsigned long long) divisors[k-1], un);
+		}
+	} else if (count <= 2) {
+		printf("\n%llu is prime\n", un);
+	} else {
+		printf("%llu has factors: %llu", un, (unsigned long long) divisors[1]);
+		for (size_t k = 2; k < count-1; k++) {
+			printf(", %llu", (unsigned long long) divisors[k]);
+		}
+		printf("\n\n%llu has %llu factors\n\n", un, (unsigned long long) count - 2);
+	}
+
+	free(divisors);
+	return 0;
+}
+
+// Factor every number on standard input, and print its prime factors
+// (or, if count_only, a summary).
+// Returns the exit status: 1 if the input had something that isn't a
+// number, or the output could not be written.
+int factor_stdin(const SpfTable *table, bool count_only) {
+	NumberReader reader;
+	NumberWriter writer;
+	number_reader_init(&reader, stdin, "standard input");
+	number_writer_init(&writer, stdout);
+
+	long numbers = 0;
+	uint64_t n;
+	int got;
+	double start = wall_time();
+	while ((got = number_reader_next(&reader, &n)) > 0) {
+		numbers++;
+		Factorization f;
+		factor_number(table, n, &f);
+		if (count_only) {
+			continue;
+		}
+		number_writer_put(&writer, n, ':');
+		if (f.count == 0) {
+			number_writer_text(&writer, "\n");
+			continue;
+		}
+		number_writer_text(&writer, " ");
+		for (int i = 0; i < f.count; i++) {
+			for (int e = 1; e <= f.exponent[i]; e++) {
+				bool last = i == f.count-1 && e == f.exponent[i];
+				number_writer_put(&writer, f.prime[i], last ? '\n' : ' ');
+			}
+		}
+	}
+	double seconds = wall_time() - start;
+
+	if (!number_writer_flush(&writer)) {
+		return 1;
+	}
+	if (got < 0) {
+		// only now, so that it comes after the numbers before it
+		number_reader_report(&reader);
+		return 1;
+	}
+
+	if (count_only) {
+		printf("Numbers:    %li\n", numbers);
+		printf("Time:       %.3lf s (%.0lf ns per number, reading included)\n", seconds,
+			numbers > 0 ? seconds / numbers * 1e9 : 0.0);
+	}
+	return 0;
+}
+
+// The prime factorization of n: looked up in the table if there is
+// one and it covers n, and found by factorize otherwise
+void factor_number(const SpfTable *table, uint64_t n, Factorization *f) {
+	if (table == NULL || !spf_factorize(table, n, f)) {
+		factorize(n, f);
+	}
+}
+
+// Read a whole number the way scanf("%i") does: in decimal, or in hex
+// or octal with a 0x or 0 prefix.  A negative number is read as 0,
+// which has no factors listed, just as the s17 programs list none.
+// Returns false if text isn't such a number.
+bool parse_scanf_int(const char *text, uint64_t *n) {
+	const char *digits = (text[0] == '-') ? text + 1 : text;
+	char *end;
+	errno = 0;
+	unsigned long long value = strtoull(digits, &end, 0);
+	if (*end != '\0' || end == digits || errno == ERANGE || digits[0] == '-'
+			|| digits[0] == '+') {
+		return false;
+	}
+	*n = (digits == text) ? value : 0;
+	return true;
+}
+
+// Print prompt and read a number from standard input into n.
+// Returns false, with a message, if there is no number to read.
+bool read_number(const char *prompt, uint64_t *n) {
+	char text[64];
+	printf("%s", prompt);
+	if (scanf("%63s", text) != 1) {
+		printf("\nNo number given\n");
+		return false;
+	}
+	if (!parse_scanf_int(text, n)) {
+		printf("%s is not a whole number\n", text);
+		return false;
+	}
+	return true;
+}
+
+void usage(void) {
+	printf("Usage: factors.exe [-p] [-t TABLE] [N]\n");
+	printf("       factors.exe -b [-c] [-t TABLE] < FILE\n");
+	printf("  N           number to factor (asked for if not given)\n");
+	printf("  -p          list the factors in increasing order and count them,\n");
+	printf("              or say that N is prime\n");
+	printf("  -b          print the prime factors of each number on standard input\n");
+	printf("  -c          with -b, only report the time taken\n");
+	printf("  -t TABLE    look factors up in TABLE, made by spftable.exe\n");
+}
@@ -0,0 +1,111 @@
+// Test whether numbers are prime, exactly, for any number up to 2^64-1.
+//
+//   isprime.exe N...
+//   isprime.exe [-c] < FILE
+//
+// With numbers on the command line, says whether each one is prime:
+//
+//   ./isprime.exe 1000000000039
+//   1000000000039 is prime
+//
+// With none, reads whole numbers (separated by spaces or newlines)
+// from standard input and prints the ones that are prime, one per
+// line, or with -c only counts them and reports how long the tests
+// took.  The classroom test_prime.cpp tries every divisor up to n/2;
+// this uses a little trial division and then the Miller-Rabin test
+// (see primality.cpp), which takes well under a microsecond.
+
+#include <stdio.h>
+#include <string.h>
+#include "numread.h"
+#include "numwrite.h"
+#include "primality.h"
+#include "timer.h"
+
+int test_args(int argc, char *argv[]);
+int test_stdin(bool count_only);
+void usage(void);
+
+int main(int argc, char *argv[]) {
+	if (argc == 1) {
+		return test_stdin(false);
+	}
+	if (argc == 2 && strcmp(argv[1], "-c") == 0) {
+		return test_stdin(true);
+	}
+	if (argv[1][0] == '-') {
+		usage();
+		return 1;
+	}
+	return test_args(argc, argv);
+}
+
+// Say whether each number on the command line is prime.
+// Returns the exit status: 1 if any of them isn't a number.
+int test_args(int argc, char *argv[]) {
+	int status = 0;
+	for (int i = 1; i < argc; i++) {
+		unsigned long long n;
+		char end;
+		if (sscanf(argv[i], "%llu%c", &n, &end) != 1 || argv[i][0] == '-') {
+			printf("%s is not a whole number\n", argv[i]);
+			status = 1;
+		} else if (is_prime(n)) {
+			printf("%llu is prime\n", n);
+		} else {
+			printf("%llu is not prime\n", n);
+		}
+	}
+	return status;
+}
+
+// Test every number on standard input, and print the primes (or, if
+// count_only, a summary).
+// Returns the exit status: 1 if the input had something that isn't a
+// number, or the output could not be written.
+int test_stdin(bool count_only) {
+	NumberReader reader;
+	NumberWriter writer;
+	number_reader_init(&reader, stdin, "standard input");
+	number_writer_init(&writer, stdout);
+
+	long numbers = 0, primes = 0;
+	uint64_t n;
+	int got;
+	double start = wall_time();
+	while ((got = number_reader_next(&reader, &n)) > 0) {
+		numbers++;
+		if (is_prime(n)) {
+			primes++;
+			if (!count_only) {
+				number_writer_put(&writer, n, '\n');
+			}
+		}
+	}
+	double seconds = wall_time() - start;
+
+	if (!number_writer_flush(&writer)) {
+		return 1;
+	}
+	if (got < 0) {
+		// only now, so that it comes after the numbers before it
+		number_reader_report(&reader);
+		return 1;
+	}
+
+	if (count_only) {
+		printf("Numbers:    %li\n", numbers);
+		printf("Primes:     %li\n", primes);
+		printf("Time:       %.3lf s (%.0lf ns per number, reading included)\n", seconds,
+			numbers > 0 ? seconds / numbers * 1e9 : 0.0);
+	}
+	return 0;
+}
+
+void usage(void) {
+	printf("Usage: isprime.exe N...\n");
+	printf("       isprime.exe [-c] < FILE\n");
+	printf("  N...        say whether each number is prime\n");
+	printf("  (none)      print the primes among the numbers on standard input\n");
+	printf("  -c          only count them, and report the time taken\n");
+}
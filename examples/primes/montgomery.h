@@ -0,0 +1,85 @@
+#ifndef MONTGOMERY_H
+#define MONTGOMERY_H
+
+#include <stdint.h>
+
+// Arithmetic modulo an odd 64-bit n in Montgomery form: x is stored as
+// x R mod n, with R = 2^64.  Then a product only needs a 64x64 to 128
+// bit multiplication and a reduction made of two more multiplications,
+// instead of dividing a 128-bit number by n (which takes tens of
+// cycles on most CPUs).  Numbers in Montgomery form are always less
+// than n.  Everything here is inline, since it is the inner loop of
+// the primality test and of factoring.
+struct Montgomery {
+	uint64_t n;
+	uint64_t inv;     // n^-1 mod 2^64
+	uint64_t r2;      // R^2 mod n, to convert into Montgomery form
+	uint64_t one;     // 1 in Montgomery form (R mod n)
+};
+
+// Set up arithmetic modulo n, which must be odd
+static inline void montgomery_init(Montgomery *m, uint64_t n) {
+	m->n = n;
+
+	// Newton's iteration doubles the correct low bits each time, and
+	// n itself is already right in the low 3 bits (n n = 1 mod 8)
+	uint64_t inv = n;
+	for (int i = 0; i < 5; i++) {
+		inv *= 2 - n * inv;
+	}
+	m->inv = inv;
+
+	m->one = (0 - n) % n;
+	m->r2 = (uint64_t) ((unsigned __int128) m->one * m->one % n);
+}
+
+// t R^-1 mod n, for t < n R
+static inline uint64_t montgomery_reduce(const Montgomery *m, unsigned __int128 t) {
+	uint64_t lo = (uint64_t) t;
+	uint64_t hi = (uint64_t) (t >> 64);
+	uint64_t q = lo * m->inv;
+	uint64_t qn = (uint64_t) (((unsigned __int128) q * m->n) >> 64);
+	// t - q n is a multiple of R (its low half is 0), so only the high
+	// halves need to be subtracted
+	return (hi >= qn) ? hi - qn : hi - qn + m->n;
+}
+
+// a b in Montgomery form, for a and b in Montgomery form
+static inline uint64_t montgomery_mul(const Montgomery *m, uint64_t a, uint64_t b) {
+	return montgomery_reduce(m, (unsigned __int128) a * b);
+}
+
+// Convert x (which can be any 64-bit number) into Montgomery form
+static inline uint64_t montgomery_to(const Montgomery *m, uint64_t x) {
+	return montgomery_mul(m, x < m->n ? x : x % m->n, m->r2);
+}
+
+// Convert x out of Montgomery form
+static inline uint64_t montgomery_from(const Montgomery *m, uint64_t x) {
+	return montgomery_reduce(m, x);
+}
+
+// a + b and a - b in Montgomery form (they add like ordinary residues)
+static inline uint64_t montgomery_add(const Montgomery *m, uint64_t a, uint64_t b) {
+	uint64_t s = a + b;
+	return (s < a || s >= m->n) ? s - m->n : s;
+}
+
+static inline uint64_t montgomery_sub(const Montgomery *m, uint64_t a, uint64_t b) {
+	return (a >= b) ? a - b : a - b + m->n;
+}
+
+// a^e in Montgomery form, for a in Montgomery form
+static inline uint64_t montgomery_pow(const Montgomery *m, uint64_t a, uint64_t e) {
+	uint64_t result = m->one;
+	while (e != 0) {
+		if (e & 1) {
+			result = montgomery_mul(m, result, a);
+		}
+		a = montgomery_mul(m, a, a);
+		e >>= 1;
+	}
+	return result;
+}
+
+#endif // MONTGOMERY_H
@@ -0,0 +1,8 @@
+#ifndef NUMPARSE_H
+#define NUMPARSE_H
+
+#include <stdint.h>
+
+bool parse_number(const char *text, uint64_t *n);
+
+#endif // NUMPARSE_H
@@ -0,0 +1,73 @@
+#include <ctype.h>
+#include "numread.h"
+
+void number_reader_init(NumberReader *r, FILE *file, const char *name) {
+	r->file = file;
+	r->name = name;
+	r->pos = 0;
+	r->len = 0;
+	r->line = 1;
+	r->error = NULL;
+}
+
+// The next character, without taking it, or EOF at the end of the file
+static inline int peek(NumberReader *r) {
+	if (r->pos == r->len) {
+		r->len = fread(r->buf, 1, NUMBER_BUFFER_SIZE, r->file);
+		r->pos = 0;
+		if (r->len == 0) {
+			return EOF;
+		}
+	}
+	return (unsigned char) r->buf[r->pos];
+}
+
+// Read the next number into n.
+// Returns 1 if there was one, 0 at the end of the file, or -1 if the
+// next word isn't a whole number that fits in 64 bits.  Nothing is
+// printed then, so that the caller can write out what it has first,
+// and then print what was wrong with number_reader_report.
+int number_reader_next(NumberReader *r, uint64_t *n) {
+	int c = peek(r);
+	while (c != EOF && isspace(c)) {
+		if (c == '\n') {
+			r->line++;
+		}
+		r->pos++;
+		c = peek(r);
+	}
+	if (c == EOF) {
+		return 0;
+	}
+
+	uint64_t value = 0;
+	bool overflow = false;
+	int digits = 0;
+	while (c != EOF && isdigit(c)) {
+		uint64_t digit = c - '0';
+		if (value > (UINT64_MAX - digit) / 10) {
+			overflow = true;
+		}
+		value = value * 10 + digit;
+		digits++;
+		r->pos++;
+		c = peek(r);
+	}
+
+	if (digits == 0 || (c != EOF && !isspace(c))) {
+		r->error = "not a whole number";
+		return -1;
+	}
+	if (overflow) {
+		r->error = "number too big (the limit is 18446744073709551615)";
+		return -1;
+	}
+	*n = value;
+	return 1;
+}
+
+// Print the line number and what was wrong with the word that
+// number_reader_next last refused.
+void number_reader_report(const NumberReader *r) {
+	printf("%s, line %li: %s\n", r->name, r->line, r->error);
+}
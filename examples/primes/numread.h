@@ -0,0 +1,26 @@
+#ifndef NUMREAD_H
+#define NUMREAD_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "numwrite.h"
+
+// Reads whole numbers, separated by any white space, from a file.  The
+// file is read in large blocks and the digits are converted here;
+// scanf("%llu") per number takes longer than testing it does.  Line
+// numbers are kept for error messages.
+struct NumberReader {
+	FILE *file;
+	const char *name;   // for error messages
+	size_t pos;
+	size_t len;
+	long line;
+	const char *error;  // what was wrong, when number_reader_next returns -1
+	char buf[NUMBER_BUFFER_SIZE];
+};
+
+void number_reader_init(NumberReader *r, FILE *file, const char *name);
+int number_reader_next(NumberReader *r, uint64_t *n);
+void number_reader_report(const NumberReader *r);
+
+#endif // NUMREAD_H
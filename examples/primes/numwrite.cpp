@@ -0,0 +1,61 @@
+#include <string.h>
+#include "numwrite.h"
+
+// longest text number_writer_put adds: 20 digits and a separator
+#define MAX_NUMBER_TEXT 21
+
+void number_writer_init(NumberWriter *w, FILE *file) {
+	w->file = file;
+	w->len = 0;
+	w->failed = false;
+}
+
+// Write out the buffer if there isn't room for need more characters
+static void make_room(NumberWriter *w, size_t need) {
+	if (w->len + need > NUMBER_BUFFER_SIZE) {
+		number_writer_flush(w);
+	}
+}
+
+// Add n in decimal, followed by sep
+void number_writer_put(NumberWriter *w, uint64_t n, char sep) {
+	make_room(w, MAX_NUMBER_TEXT);
+
+	// digits come out backwards, so build them at the end of a scratch area
+	char digits[MAX_NUMBER_TEXT];
+	int k = MAX_NUMBER_TEXT;
+	do {
+		digits[--k] = '0' + n % 10;
+		n /= 10;
+	} while (n != 0);
+
+	memcpy(&w->buf[w->len], &digits[k], MAX_NUMBER_TEXT - k);
+	w->len += MAX_NUMBER_TEXT - k;
+	w->buf[w->len++] = sep;
+}
+
+// Add a string as it is
+void number_writer_text(NumberWriter *w, const char *text) {
+	size_t n = strlen(text);
+	while (n > 0) {
+		make_room(w, n < NUMBER_BUFFER_SIZE ? n : NUMBER_BUFFER_SIZE);
+		size_t chunk = NUMBER_BUFFER_SIZE - w->len;
+		if (chunk > n) {
+			chunk = n;
+		}
+		memcpy(&w->buf[w->len], text, chunk);
+		w->len += chunk;
+		text += chunk;
+		n -= chunk;
+	}
+}
+
+// Write out whatever is in the buffer.
+// Returns false if this or any earlier write failed.
+bool number_writer_flush(NumberWriter *w) {
+	if (w->len > 0 && fwrite(w->buf, 1, w->len, w->file) != w->len) {
+		w->failed = true;
+	}
+	w->len = 0;
+	return !w->failed;
+}
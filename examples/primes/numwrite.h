@@ -0,0 +1,25 @@
+#ifndef NUMWRITE_H
+#define NUMWRITE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Size of a NumberWriter's buffer
+#define NUMBER_BUFFER_SIZE (1 << 16)
+
+// Writes numbers to a file as text, formatting them itself into a
+// buffer that goes out in large writes.  printf("%llu\n") per number
+// costs more than finding the primes does.
+struct NumberWriter {
+	FILE *file;
+	size_t len;
+	bool failed;      // a write failed
+	char buf[NUMBER_BUFFER_SIZE];
+};
+
+void number_writer_init(NumberWriter *w, FILE *file);
+void number_writer_put(NumberWriter *w, uint64_t n, char sep);
+void number_writer_text(NumberWriter *w, const char *text);
+bool number_writer_flush(NumberWriter *w);
+
+#endif // NUMWRITE_H
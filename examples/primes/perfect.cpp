@@ -0,0 +1,221 @@
+// Find the perfect, abundant or deficient numbers in a range, with a
+// sieve for the sum of divisors.
+//
+//   perfect.exe [-l LO] [-n HI] [-k perfect|abundant|deficient] [-v]
+//               [-j THREADS] [-S SIZE] [-c] [-o FILE]
+//
+// A number is perfect if it is the sum of its divisors other than
+// itself (6 = 1 + 2 + 3), abundant if that sum is bigger, and deficient
+// if it is smaller.  The numbers n with LO <= n < HI (default 1..10000)
+// of the kind chosen with -k (default perfect) are printed one per
+// line, or written to FILE with -o.  -v adds the sum of all of the
+// divisors and how many there are, e.g. "28 56 6".  -c only counts
+// the numbers of each kind.  With -c or -o, a summary is printed.  LO
+// and HI can be written with exponents, e.g. -n 1e10, and HI can be
+// up to 2^53.
+//
+// The Perfect Number exercise of assignment 3 adds up the divisors of
+// one number by trying all of them.  This computes the sums for the
+// whole range at once (see divsieve.cpp): -j THREADS splits the range
+// among threads in segments of SIZE numbers (default 32768).  For
+// example
+//
+//   ./perfect.exe -n 1e9 -c -j 8
+//
+// classifies every number below a billion.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "divsieve.h"
+#include "numparse.h"
+#include "numwrite.h"
+#include "timer.h"
+
+// The kinds of numbers that can be listed
+enum NumberKind {
+	KIND_DEFICIENT,
+	KIND_PERFECT,
+	KIND_ABUNDANT
+};
+
+struct Options {
+	uint64_t lo;
+	uint64_t hi;
+	DivisorParams params;
+	int kind;
+	bool verbose;
+	bool count_only;
+	const char *output_file;
+};
+
+// What the callback needs to list the numbers
+struct ListState {
+	NumberWriter *writer;
+	int kind;
+	bool verbose;
+};
+
+bool parse_options(int argc, char *argv[], Options *opts);
+void usage(void);
+void write_numbers(const DivisorSegment *segment, void *arg);
+
+int main(int argc, char *argv[]) {
+	Options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if (opts.output_file != NULL) {
+		out = fopen(opts.output_file, "w");
+		if (out == NULL) {
+			printf("Can't write to %s\n", opts.output_file);
+			return 1;
+		}
+	}
+
+	NumberWriter writer;
+	number_writer_init(&writer, out);
+	ListState state;
+	state.writer = &writer;
+	state.kind = opts.kind;
+	state.verbose = opts.verbose;
+	if (!opts.count_only) {
+		opts.params.callback = write_numbers;
+		opts.params.arg = &state;
+	}
+
+	double start = wall_time();
+	DivisorCounts counts;
+	bool ok = divisor_sieve(opts.lo, opts.hi, &opts.params, &counts);
+	if (ok && !opts.count_only && !number_writer_flush(&writer)) {
+		printf("Error writing the numbers\n");
+		ok = false;
+	} else if (!ok) {
+		printf("Not enough memory to sieve\n");
+	}
+	double seconds = wall_time() - start;
+
+	if (out != stdout) {
+		if (fclose(out) != 0 && ok) {
+			printf("Error writing to %s\n", opts.output_file);
+			ok = false;
+		}
+	}
+	if (!ok) {
+		return 1;
+	}
+
+	if (opts.count_only || opts.output_file != NULL) {
+		printf("Range:      [%llu, %llu)\n", (unsigned long long) opts.lo,
+			(unsigned long long) opts.hi);
+		printf("Deficient:  %llu\n", (unsigned long long) counts.deficient);
+		printf("Perfect:    %llu\n", (unsigned long long) counts.perfect);
+		printf("Abundant:   %llu\n", (unsigned long long) counts.abundant);
+		printf("Time:       %.3lf s\n", seconds);
+		printf("Threads:    %i\n", opts.params.nthreads);
+		printf("Segments:   %lu numbers\n", (unsigned long) opts.params.segment_size);
+	}
+
+	return 0;
+}
+
+// Write the numbers of the chosen kind in a segment (a DivisorCallback)
+void write_numbers(const DivisorSegment *segment, void *arg) {
+	ListState *state = (ListState *) arg;
+	for (size_t i = 0; i < segment->count; i++) {
+		uint64_t n = segment->first + i;
+		uint64_t sigma = segment->sigma[i];
+		int kind = (sigma < 2 * n) ? KIND_DEFICIENT
+			: (sigma == 2 * n) ? KIND_PERFECT : KIND_ABUNDANT;
+		if (kind != state->kind) {
+			continue;
+		}
+		if (state->verbose) {
+			number_writer_put(state->writer, n, ' ');
+			number_writer_put(state->writer, sigma, ' ');
+			number_writer_put(state->writer, segment->ndivisors[i], '\n');
+		} else {
+			number_writer_put(state->writer, n, '\n');
+		}
+	}
+}
+
+// Read the command line arguments into opts.
+// Returns false if they don't make sense.
+bool parse_options(int argc, char *argv[], Options *opts) {
+	opts->lo = 1;
+	opts->hi = 10000;
+	divisor_params_init(&opts->params);
+	opts->kind = KIND_PERFECT;
+	opts->verbose = false;
+	opts->count_only = false;
+	opts->output_file = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		// options without a value
+		if (strcmp(argv[i], "-c") == 0) {
+			opts->count_only = true;
+			continue;
+		}
+		if (strcmp(argv[i], "-v") == 0) {
+			opts->verbose = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-l") == 0) {
+			if (!parse_number(value, &opts->lo)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-n") == 0) {
+			if (!parse_number(value, &opts->hi)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-k") == 0) {
+			if (strcmp(value, "perfect") == 0) {
+				opts->kind = KIND_PERFECT;
+			} else if (strcmp(value, "abundant") == 0) {
+				opts->kind = KIND_ABUNDANT;
+			} else if (strcmp(value, "deficient") == 0) {
+				opts->kind = KIND_DEFICIENT;
+			} else {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->params.nthreads = atoi(value);
+		} else if (strcmp(argv[i], "-S") == 0) {
+			opts->params.segment_size = atol(value);
+		} else if (strcmp(argv[i], "-o") == 0) {
+			opts->output_file = value;
+		} else {
+			return false;
+		}
+		i++;
+	}
+
+	if (opts->lo == 0) {
+		// 0 is a multiple of everything, and none of the kinds
+		opts->lo = 1;
+	}
+	return opts->lo <= opts->hi && opts->hi <= DIVSIEVE_MAX && opts->params.nthreads >= 1
+		&& (long) opts->params.segment_size >= 1;
+}
+
+void usage(void) {
+	printf("Usage: perfect.exe [-l LO] [-n HI] [-k perfect|abundant|deficient] [-v]\n");
+	printf("                   [-j THREADS] [-S SIZE] [-c] [-o FILE]\n");
+	printf("  -l LO       smallest number to consider (default 1)\n");
+	printf("  -n HI       consider the numbers below HI (default 10000, at most 2^53)\n");
+	printf("  -k KIND     list the perfect (the default), abundant or deficient numbers\n");
+	printf("  -v          also print the sum of the divisors and how many there are\n");
+	printf("  -j THREADS  number of threads sieving segments (default 1)\n");
+	printf("  -S SIZE     numbers per segment (default %i)\n", DIVSIEVE_SEGMENT);
+	printf("  -c          only count the numbers of each kind\n");
+	printf("  -o FILE     write the numbers to FILE instead of the screen\n");
+}
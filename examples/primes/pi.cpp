@@ -0,0 +1,86 @@
+// Count the primes up to a number, without finding them.
+//
+//   pi.exe [-s] X...
+//
+// Prints pi(X), the number of primes up to and including X, for each
+// X (at most 2^53; exponents like 1e12 are allowed):
+//
+//   ./pi.exe 1e12
+//   pi(1000000000000) = 37607912018 (1.242 s)
+//
+// This takes about X^(3/4) steps (see primecount.cpp), so it is much
+// faster than counting with primes.exe, which sieves every number up
+// to X.  -s counts with the sieve as well, as a check, and reports
+// whether the two agree.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numparse.h"
+#include "primecount.h"
+#include "sieve.h"
+#include "timer.h"
+
+void usage(void);
+
+int main(int argc, char *argv[]) {
+	bool check = false;
+	int first = 1;
+	if (argc > 1 && strcmp(argv[1], "-s") == 0) {
+		check = true;
+		first = 2;
+	}
+	if (first >= argc) {
+		usage();
+		return 1;
+	}
+
+	int status = 0;
+	for (int i = first; i < argc; i++) {
+		uint64_t x;
+		if (!parse_number(argv[i], &x) || x > PRIME_COUNT_MAX) {
+			printf("%s is not a whole number up to 2^53\n", argv[i]);
+			status = 1;
+			continue;
+		}
+
+		double start = wall_time();
+		uint64_t count;
+		if (!prime_count(x, &count)) {
+			printf("Not enough memory to count the primes up to %s\n", argv[i]);
+			status = 1;
+			continue;
+		}
+		printf("pi(%llu) = %llu (%.3lf s)\n", (unsigned long long) x,
+			(unsigned long long) count, wall_time() - start);
+
+		if (!check) {
+			continue;
+		}
+		if (x >= SIEVE_MAX) {
+			printf("  too big to check with the sieve\n");
+			continue;
+		}
+		SieveParams params;
+		sieve_params_init(&params);
+		start = wall_time();
+		uint64_t sieved;
+		if (!sieve_range(0, x + 1, &params, &sieved)) {
+			printf("Not enough memory to sieve\n");
+			status = 1;
+			continue;
+		}
+		printf("  sieve:   %llu (%.3lf s), %s\n", (unsigned long long) sieved,
+			wall_time() - start, sieved == count ? "the same" : "DIFFERENT");
+		if (sieved != count) {
+			status = 1;
+		}
+	}
+	return status;
+}
+
+void usage(void) {
+	printf("Usage: pi.exe [-s] X...\n");
+	printf("  X...        count the primes up to each X (at most 2^53)\n");
+	printf("  -s          count them with the sieve too, as a check\n");
+}
@@ -0,0 +1,185 @@
+#include "montgomery.h"
+#include "primality.h"
+
+// The odd primes tried by trial division, with what is needed to test
+// whether n is a multiple of p without dividing: since p is odd it has
+// an inverse mod 2^64, and n is a multiple of p exactly when
+// n p^-1 mod 2^64 (which is then n / p) is at most (2^64 - 1) / p.
+struct TrialPrime {
+	uint64_t p;
+	uint64_t inv;     // p^-1 mod 2^64
+	uint64_t limit;   // (2^64 - 1) / p
+};
+
+static const TrialPrime trial_primes[] = {
+	{  3, 0xaaaaaaaaaaaaaaabULL, 0x5555555555555555ULL },
+	{  5, 0xcccccccccccccccdULL, 0x3333333333333333ULL },
+	{  7, 0x6db6db6db6db6db7ULL, 0x2492492492492492ULL },
+	{ 11, 0x2e8ba2e8ba2e8ba3ULL, 0x1745d1745d1745d1ULL },
+	{ 13, 0x4ec4ec4ec4ec4ec5ULL, 0x13b13b13b13b13b1ULL },
+	{ 17, 0xf0f0f0f0f0f0f0f1ULL, 0x0f0f0f0f0f0f0f0fULL },
+	{ 19, 0x86bca1af286bca1bULL, 0x0d79435e50d79435ULL },
+	{ 23, 0xd37a6f4de9bd37a7ULL, 0x0b21642c8590b216ULL },
+	{ 29, 0x34f72c234f72c235ULL, 0x08d3dcb08d3dcb08ULL },
+	{ 31, 0xef7bdef7bdef7bdfULL, 0x0842108421084210ULL },
+	{ 37, 0x14c1bacf914c1badULL, 0x06eb3e45306eb3e4ULL },
+	{ 41, 0x8f9c18f9c18f9c19ULL, 0x063e7063e7063e70ULL },
+	{ 43, 0x82fa0be82fa0be83ULL, 0x05f417d05f417d05ULL },
+	{ 47, 0x51b3bea3677d46cfULL, 0x0572620ae4c415c9ULL },
+	{ 53, 0x21cfb2b78c13521dULL, 0x04d4873ecade304dULL },
+};
+
+#define NUM_TRIAL_PRIMES (int) (sizeof(trial_primes) / sizeof(trial_primes[0]))
+
+// Numbers below this that have no factor up to the largest trial prime
+// (53) are prime
+#define TRIAL_BOUND (59 * 59)
+
+// Miller-Rabin bases that make the test exact below each bound (the
+// first two sets are Jaeschke's; the last, found by Jim Sinclair, is
+// exact for every 64-bit number)
+static const uint64_t bases_32[] = { 2, 7, 61 };
+static const uint64_t bases_40[] = { 2, 13, 23, 1662803 };
+static const uint64_t bases_64[] = { 2, 325, 9375, 28178, 450775, 9780504, 1795265022 };
+
+#define BOUND_32 4759123141ULL
+#define BOUND_40 1122004669633ULL
+
+// The smallest prime factor of n up to 53 (2 for even n), or 0 if n
+// has none.  n must be at least 2.
+uint64_t small_factor(uint64_t n) {
+	if (n % 2 == 0) {
+		return 2;
+	}
+	for (int i = 0; i < NUM_TRIAL_PRIMES; i++) {
+		if (n * trial_primes[i].inv <= trial_primes[i].limit) {
+			return trial_primes[i].p;
+		}
+	}
+	return 0;
+}
+
+// Most bases used below
+#define MAX_BASES 7
+
+// The strong probable prime test of n to the bases a[0..K-1] (in
+// Montgomery form, and not 0), where n - 1 = d 2^s with d odd.
+//
+// Every base is raised to the same power, so the powers are computed
+// side by side, one bit of the exponent at a time for all of the
+// bases.  A single modular exponentiation is a chain of dependent
+// multiplications, which leaves the CPU waiting on each one; the
+// chains of different bases are independent, so the CPU overlaps them.
+// K is a template parameter so that the loops over the bases are
+// unrolled and the powers stay in registers.
+// Returns false if some base proves n composite.
+template <int K>
+static bool strong_test(const Montgomery *m, const uint64_t *a, uint64_t d, int s) {
+	uint64_t x[K];
+	for (int i = 0; i < K; i++) {
+		x[i] = a[i];
+	}
+
+	// x = a^d, from the top bit of d (which x already has) down
+	for (int bit = 62 - __builtin_clzll(d); bit >= 0; bit--) {
+		for (int i = 0; i < K; i++) {
+			x[i] = montgomery_mul(m, x[i], x[i]);
+		}
+		if ((d >> bit) & 1) {
+			for (int i = 0; i < K; i++) {
+				x[i] = montgomery_mul(m, x[i], a[i]);
+			}
+		}
+	}
+
+	// n passes base a if a^d = 1, or a^(d 2^r) = -1 for some r < s
+	uint64_t minus_one = m->n - m->one;
+	for (int i = 0; i < K; i++) {
+		if (x[i] == m->one || x[i] == minus_one) {
+			continue;
+		}
+		bool passed = false;
+		for (int r = 1; r < s && !passed; r++) {
+			x[i] = montgomery_mul(m, x[i], x[i]);
+			passed = x[i] == minus_one;
+		}
+		if (!passed) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// strong_test for k bases, for any k up to MAX_BASES
+static bool strong_test_k(const Montgomery *m, const uint64_t *a, int k, uint64_t d, int s) {
+	switch (k) {
+	case 0:
+		return true;
+	case 1:
+		return strong_test<1>(m, a, d, s);
+	case 2:
+		return strong_test<2>(m, a, d, s);
+	case 3:
+		return strong_test<3>(m, a, d, s);
+	case 4:
+		return strong_test<4>(m, a, d, s);
+	case 5:
+		return strong_test<5>(m, a, d, s);
+	default:
+		return strong_test<6>(m, a, d, s) && strong_test_k(m, a + 6, k - 6, d, s);
+	}
+}
+
+// The Miller-Rabin test of n to each of the given bases (at most
+// MAX_BASES).  n must be odd and at least 3.  Nearly every composite
+// fails the first base, so it is tried on its own, and only numbers
+// that pass go on to the others, which are then tested side by side.
+// Returns false if some base proves n composite.
+bool miller_rabin(uint64_t n, const uint64_t *bases, int nbases) {
+	// n - 1 = d 2^s with d odd
+	uint64_t d = n - 1;
+	int s = __builtin_ctzll(d);
+	d >>= s;
+
+	Montgomery m;
+	montgomery_init(&m, n);
+
+	// bases that are multiples of n say nothing about it, and are left out
+	uint64_t a[MAX_BASES];
+	int k = 0;
+	for (int i = 0; i < nbases; i++) {
+		a[k] = montgomery_to(&m, bases[i]);
+		if (a[k] != 0) {
+			k++;
+		}
+	}
+
+	if (k == 0) {
+		return true;
+	}
+	return strong_test<1>(&m, a, d, s) && strong_test_k(&m, a + 1, k - 1, d, s);
+}
+
+// Whether n is prime, exactly, for any 64-bit n: trial division by the
+// primes up to 53 (which settles most numbers), then Miller-Rabin with
+// a set of bases known to have no exceptions up to n's size.
+bool is_prime(uint64_t n) {
+	if (n < 2) {
+		return false;
+	}
+	uint64_t f = small_factor(n);
+	if (f != 0) {
+		return f == n;
+	}
+	if (n < TRIAL_BOUND) {
+		return true;
+	}
+
+	if (n < BOUND_32) {
+		return miller_rabin(n, bases_32, 3);
+	}
+	if (n < BOUND_40) {
+		return miller_rabin(n, bases_40, 4);
+	}
+	return miller_rabin(n, bases_64, 7);
+}
@@ -0,0 +1,10 @@
+#ifndef PRIMALITY_H
+#define PRIMALITY_H
+
+#include <stdint.h>
+
+bool is_prime(uint64_t n);
+uint64_t small_factor(uint64_t n);
+bool miller_rabin(uint64_t n, const uint64_t *bases, int nbases);
+
+#endif // PRIMALITY_H
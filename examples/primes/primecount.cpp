@@ -0,0 +1,125 @@
+#include <math.h>
+#include <stdlib.h>
+#include "primecount.h"
+
+// Counting the primes up to x without finding them, by the method
+// Lucy_Hedgehog posted on Project Euler (a relative of Legendre's and
+// Meissel's formulas).
+//
+// Let S(v, p) be how many numbers 2..v are left after crossing off the
+// multiples of the primes below p, except for those primes themselves,
+// as in the sieve of Eratosthenes.  S(v, 2) = v - 1, and once p is past
+// the square root of v, S(v, p) is the number of primes up to v.
+// Crossing off the multiples of a prime p takes away the numbers left
+// whose smallest prime factor is p, which are p times the numbers from
+// p up to v / p that are left:
+//
+//   S(v, p+1) = S(v, p) - (S(v / p, p) - S(p - 1, p))
+//
+// (the second term is the primes below p, which have been counted in
+// S(v / p, p) but are not smaller than p).  Only values of v of the
+// form x / i are ever needed, and there are only about 2 sqrt(x) of
+// them: every v up to sqrt(x), and x / i for each i up to sqrt(x).
+// So S is kept in two arrays of sqrt(x) entries, updated in place for
+// each prime p up to sqrt(x), which takes about x^(3/4) steps in all:
+// about 10^9 steps to count the primes up to 10^12, where a sieve
+// would go through 10^12 numbers.
+
+// q / p for q < 2^53, with inv = 1/p: a multiplication in double
+// precision is off by at most 1, and is corrected, which is much
+// faster than dividing
+static inline uint64_t divide(uint64_t q, uint64_t p, double inv) {
+	uint64_t t = (uint64_t) ((double) q * inv);
+	if (t * p > q) {
+		t--;
+	} else if ((t + 1) * p <= q) {
+		t++;
+	}
+	return t;
+}
+
+// Set *count to the number of primes up to and including x, which must
+// be at most PRIME_COUNT_MAX, in about x^(3/4) time and 24 sqrt(x)
+// bytes of memory.
+// Returns false if memory could not be allocated.
+bool prime_count(uint64_t x, uint64_t *count) {
+	*count = 0;
+	if (x < 2) {
+		return true;
+	}
+
+	uint64_t r = (uint64_t) sqrtl((long double) x);
+	while (r * r > x) {
+		r--;
+	}
+	while ((r + 1) * (r + 1) <= x) {
+		r++;
+	}
+
+	// small[v] is S(v, p) for v <= r, and large[i] is S(x / i, p) for
+	// i <= r, with quotient[i] = x / i
+	uint64_t *small = (uint64_t *) malloc((r + 1) * sizeof(uint64_t));
+	uint64_t *large = (uint64_t *) malloc((r + 1) * sizeof(uint64_t));
+	uint64_t *quotient = (uint64_t *) malloc((r + 1) * sizeof(uint64_t));
+	if (small == NULL || large == NULL || quotient == NULL) {
+		free(small);
+		free(large);
+		free(quotient);
+		return false;
+	}
+	small[0] = 0;
+	for (uint64_t v = 1; v <= r; v++) {
+		small[v] = v - 1;
+	}
+	for (uint64_t i = 1; i <= r; i++) {
+		quotient[i] = x / i;
+		large[i] = quotient[i] - 1;
+	}
+
+	for (uint64_t p = 2; p <= r; p++) {
+		if (small[p] == small[p-1]) {
+			continue;     // p was crossed off, so it isn't prime
+		}
+		uint64_t below = small[p-1];     // the primes below p
+		uint64_t p2 = p * p;
+
+		// Only the v that are at least p^2 change.  The large entries
+		// are done in increasing order of i, and so of decreasing v,
+		// so the S(v / p) each one needs is still the one for p.  For
+		// i p <= r, v / p = x / (i p) is a large entry itself.
+		uint64_t iend = x / p2;
+		if (iend > r) {
+			iend = r;
+		}
+		uint64_t imid = r / p;
+		if (imid > iend) {
+			imid = iend;
+		}
+		for (uint64_t i = 1; i <= imid; i++) {
+			large[i] -= large[i * p] - below;
+		}
+		double inv = 1.0 / p;
+		for (uint64_t i = imid + 1; i <= iend; i++) {
+			large[i] -= small[divide(quotient[i], p, inv)] - below;
+		}
+
+		// The small entries are done from the top down, p at a time:
+		// the v from q p to q p + p - 1 all have v / p = q.
+		for (uint64_t q = r / p; q >= p; q--) {
+			uint64_t sub = small[q] - below;
+			uint64_t vend = q * p + p - 1;
+			if (vend > r) {
+				vend = r;
+			}
+			for (uint64_t v = q * p; v <= vend; v++) {
+				small[v] -= sub;
+			}
+		}
+	}
+
+	*count = large[1];
+	free(small);
+	free(large);
+	free(quotient);
+	return true;
+}
@@ -0,0 +1,12 @@
+#ifndef PRIMECOUNT_H
+#define PRIMECOUNT_H
+
+#include <stdint.h>
+
+// Largest x whose primes can be counted (quotients are found with
+// double precision, which is exact up to 2^53)
+#define PRIME_COUNT_MAX (1ULL << 53)
+
+bool prime_count(uint64_t x, uint64_t *count);
+
+#endif // PRIMECOUNT_H
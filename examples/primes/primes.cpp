@@ -0,0 +1,157 @@
+// List or count the prime numbers in a range, with a segmented sieve
+// of Eratosthenes.
+//
+//   primes.exe [-l LO] [-n HI] [-j THREADS] [-S KB] [-c] [-o FILE]
+//
+// The primes p with LO <= p < HI (default 2..100) are printed one per
+// line, or written to FILE with -o.  -c only counts them.  With -c or
+// -o, a summary of how many were found and how long it took is
+// printed.  LO and HI can be written with exponents, e.g. -n 1e10,
+// and HI can be up to 2^62 (though near that, even a short range needs
+// a few seconds and about 400 MB for the primes up to its square root).
+//
+// -j THREADS splits the segments among threads.  -S KB sets the size
+// of each segment's bit array, which should fit in cache: the default
+// of 32 KB fits in the L1 data cache of most CPUs.  For example
+//
+//   ./primes.exe -n 1e10 -c -j 8
+//
+// counts the primes below 10^10 (there are 455052511).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numparse.h"
+#include "numwrite.h"
+#include "sieve.h"
+#include "timer.h"
+
+struct Options {
+	uint64_t lo;
+	uint64_t hi;
+	SieveParams params;
+	bool count_only;
+	const char *output_file;
+};
+
+bool parse_options(int argc, char *argv[], Options *opts);
+void usage(void);
+void write_primes(const uint64_t *primes, size_t count, void *arg);
+
+int main(int argc, char *argv[]) {
+	Options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+
+	FILE *out = stdout;
+	if (opts.output_file != NULL) {
+		out = fopen(opts.output_file, "w");
+		if (out == NULL) {
+			printf("Can't write to %s\n", opts.output_file);
+			return 1;
+		}
+	}
+
+	NumberWriter writer;
+	number_writer_init(&writer, out);
+	if (!opts.count_only) {
+		opts.params.callback = write_primes;
+		opts.params.arg = &writer;
+	}
+
+	double start = wall_time();
+	uint64_t count;
+	bool ok = sieve_range(opts.lo, opts.hi, &opts.params, &count);
+	if (ok && !opts.count_only && !number_writer_flush(&writer)) {
+		printf("Error writing the primes\n");
+		ok = false;
+	} else if (!ok) {
+		printf("Not enough memory to sieve\n");
+	}
+	double seconds = wall_time() - start;
+
+	if (out != stdout) {
+		if (fclose(out) != 0 && ok) {
+			printf("Error writing to %s\n", opts.output_file);
+			ok = false;
+		}
+	}
+	if (!ok) {
+		return 1;
+	}
+
+	if (opts.count_only || opts.output_file != NULL) {
+		printf("Primes:     %llu in [%llu, %llu)\n", (unsigned long long) count,
+			(unsigned long long) opts.lo, (unsigned long long) opts.hi);
+		printf("Time:       %.3lf s\n", seconds);
+		printf("Threads:    %i\n", opts.params.nthreads);
+		printf("Segments:   %i KB\n", opts.params.segment_kb);
+	}
+
+	return 0;
+}
+
+// Read the command line arguments into opts.
+// Returns false if they don't make sense.
+bool parse_options(int argc, char *argv[], Options *opts) {
+	opts->lo = 2;
+	opts->hi = 100;
+	sieve_params_init(&opts->params);
+	opts->count_only = false;
+	opts->output_file = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		// options without a value
+		if (strcmp(argv[i], "-c") == 0) {
+			opts->count_only = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-l") == 0) {
+			if (!parse_number(value, &opts->lo)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-n") == 0) {
+			if (!parse_number(value, &opts->hi)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->params.nthreads = atoi(value);
+		} else if (strcmp(argv[i], "-S") == 0) {
+			opts->params.segment_kb = atoi(value);
+		} else if (strcmp(argv[i], "-o") == 0) {
+			opts->output_file = value;
+		} else {
+			return false;
+		}
+		i++;
+	}
+
+	return opts->lo <= opts->hi && opts->hi <= SIEVE_MAX && opts->params.nthreads >= 1
+		&& opts->params.segment_kb >= 1;
+}
+
+void usage(void) {
+	printf("Usage: primes.exe [-l LO] [-n HI] [-j THREADS] [-S KB] [-c] [-o FILE]\n");
+	printf("  -l LO       smallest number to consider (default 2)\n");
+	printf("  -n HI       list the primes below HI (default 100, at most 2^62)\n");
+	printf("  -j THREADS  number of threads sieving segments (default 1)\n");
+	printf("  -S KB       size of a segment's bit array (default %i KB)\n", SIEVE_SEGMENT_KB);
+	printf("  -c          only count the primes\n");
+	printf("  -o FILE     write the primes to FILE instead of the screen\n");
+}
+
+// Prime callback that prints each prime on a line of its own
+// (arg is the NumberWriter)
+void write_primes(const uint64_t *primes, size_t count, void *arg) {
+	NumberWriter *writer = (NumberWriter *) arg;
+	for (size_t i = 0; i < count; i++) {
+		number_writer_put(writer, primes[i], '\n');
+	}
+}
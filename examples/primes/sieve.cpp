@@ -0,0 +1,376 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sieve.h"
+
+// The sieve of Eratosthenes, segmented: instead of one array for the
+// whole range, which for 10^10 would be far bigger than any cache, the
+// range is done one cache-sized segment at a time.  Each segment
+// crosses off the multiples of every prime up to the square root of
+// the end of the range (the base primes, found first by sieving up to
+// that square root the same way).
+//
+// Only odd numbers are kept, one bit each: bit k of the whole range
+// stands for the number 2k + 1.  That halves the memory and the work,
+// and 2 is added separately.  The multiples of the smallest primes
+// take the most crossing off, so they are pre-sieved instead: their
+// pattern of bits repeats every 3*5*7*11*13 bits, and every segment
+// starts as a copy of it.  The segments are independent, so
+// threads take them in turn; when the primes are wanted (not just
+// counted), each thread lists its segment's primes on its own, and
+// only the callbacks take turns, in segment order.
+
+// The pre-sieved primes, and the length of their pattern: it repeats
+// every 3*5*7*11*13 bits, and so every that many 64-bit words
+static const uint32_t presieve_primes[] = { 3, 5, 7, 11, 13 };
+#define NUM_PRESIEVE 5
+#define PRESIEVE_WORDS 15015
+
+void sieve_params_init(SieveParams *params) {
+	params->nthreads = 1;
+	params->segment_kb = SIEVE_SEGMENT_KB;
+	params->callback = NULL;
+	params->arg = NULL;
+}
+
+// Where small_primes puts the primes as the sieve finds them
+struct PrimeList {
+	uint32_t *primes;
+	size_t count;
+	size_t capacity;
+};
+
+static void add_to_list(const uint64_t *primes, size_t count, void *arg) {
+	PrimeList *list = (PrimeList *) arg;
+	for (size_t i = 0; i < count && list->count < list->capacity; i++) {
+		list->primes[list->count++] = (uint32_t) primes[i];
+	}
+}
+
+// All of the primes up to and including limit, in a new array that
+// the caller must free.  They are found with the segmented sieve
+// itself (whose own base primes, up to the square root of limit, are
+// few), so apart from the array only a segment's worth of memory is
+// needed, even for limits near 2^32.
+// Returns NULL if memory could not be allocated.
+uint32_t *small_primes(uint32_t limit, size_t *count) {
+	// there are at most x / ln x * (1 + 1.2762 / ln x) primes up to x
+	// (Dusart's bound, for x > 1)
+	double x = (limit > 2) ? limit : 2;
+	PrimeList list;
+	list.count = 0;
+	list.capacity = (size_t) (x / log(x) * (1.0 + 1.2762 / log(x))) + 2;
+	list.primes = (uint32_t *) malloc(list.capacity * sizeof(uint32_t));
+	if (list.primes == NULL) {
+		return NULL;
+	}
+
+	SieveParams params;
+	sieve_params_init(&params);
+	params.callback = add_to_list;
+	params.arg = &list;
+	uint64_t found;
+	if (!sieve_range(0, (uint64_t) limit + 1, &params, &found)) {
+		free(list.primes);
+		return NULL;
+	}
+	*count = list.count;
+	return list.primes;
+}
+
+// The bits of PRESIEVE_WORDS words with the odd multiples of the
+// pre-sieved primes crossed off, starting from bit 0 (the number 1).
+// Returns NULL if memory could not be allocated.
+static uint64_t *make_presieve(void) {
+	uint64_t *pattern = (uint64_t *) malloc(PRESIEVE_WORDS * sizeof(uint64_t));
+	if (pattern == NULL) {
+		return NULL;
+	}
+	memset(pattern, 0xff, PRESIEVE_WORDS * sizeof(uint64_t));
+	for (int i = 0; i < NUM_PRESIEVE; i++) {
+		uint64_t p = presieve_primes[i];
+		for (uint64_t k = (p - 1) / 2; k < 64 * PRESIEVE_WORDS; k += p) {
+			pattern[k / 64] &= ~(1ULL << (k % 64));
+		}
+	}
+	return pattern;
+}
+
+// State shared by the threads sieving one range
+struct SieveShared {
+	uint64_t klo;             // bits klo..khi-1 (the odd numbers of the range)
+	uint64_t khi;
+	uint64_t kstart;          // klo rounded down to a whole word: the first segment's start
+	uint64_t segment_bits;
+	uint64_t nsegments;
+	const uint32_t *base;     // base primes, after the pre-sieved ones
+	size_t nbase;
+	const uint64_t *presieve;
+	const SieveParams *params;
+
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+	uint64_t next_segment;    // next segment for a thread to take
+	uint64_t delivered;       // segments passed to the callback so far
+};
+
+// One thread's buffers and result
+struct SieveWorker {
+	pthread_t thread;
+	SieveShared *shared;
+	uint64_t *words;          // the segment's bits
+	uint64_t *primes;         // the segment's primes, with a callback
+	uint64_t count;
+};
+
+// Sieve the bits kbegin..kbegin+nbits-1 into words: a bit is left set
+// if its number is prime (and in the range).  kbegin must be a
+// multiple of 64.
+static void sieve_segment(const SieveShared *shared, uint64_t kbegin, uint64_t nbits,
+		uint64_t *words) {
+	uint64_t nwords = (nbits + 63) / 64;
+	uint64_t w = (kbegin / 64) % PRESIEVE_WORDS;
+	for (uint64_t i = 0; i < nwords; ) {
+		uint64_t n = PRESIEVE_WORDS - w;
+		if (n > nwords - i) {
+			n = nwords - i;
+		}
+		memcpy(&words[i], &shared->presieve[w], n * sizeof(uint64_t));
+		i += n;
+		w = 0;
+	}
+	if (nbits % 64 != 0) {
+		words[nwords-1] &= (1ULL << (nbits % 64)) - 1;
+	}
+	if (kbegin < shared->klo) {
+		words[0] &= ~0ULL << (shared->klo - kbegin);
+	}
+	if (kbegin == 0) {
+		// 1 is not prime, but the pre-sieved primes are
+		words[0] &= ~1ULL;
+		for (int i = 0; i < NUM_PRESIEVE; i++) {
+			uint64_t k = presieve_primes[i] / 2;
+			if (k >= shared->klo && k < nbits) {
+				words[0] |= 1ULL << k;
+			}
+		}
+	}
+
+	uint64_t first = 2 * kbegin + 1;            // first number in the segment
+	uint64_t last = 2 * (kbegin + nbits) - 1;   // last number in the segment
+	for (size_t i = 0; i < shared->nbase; i++) {
+		uint64_t p = shared->base[i];
+		if (p * p > last) {
+			break;
+		}
+
+		// first odd multiple of p in the segment that isn't p itself
+		// (smaller multiples have smaller prime factors, so p * p will do)
+		uint64_t m = p * p;
+		if (m < first) {
+			m = (first + p - 1) / p * p;
+			if (m % 2 == 0) {
+				m += p;
+			}
+		}
+
+		// odd multiples are 2p apart, which is p bits
+		for (uint64_t k = (m - 1) / 2 - kbegin; k < nbits; k += p) {
+			words[k / 64] &= ~(1ULL << (k % 64));
+		}
+	}
+}
+
+// List the primes left in a sieved segment.
+// Returns how many there are.
+static size_t list_primes(const uint64_t *words, uint64_t kbegin, uint64_t nbits,
+		uint64_t *primes) {
+	size_t n = 0;
+	uint64_t nwords = (nbits + 63) / 64;
+	for (uint64_t i = 0; i < nwords; i++) {
+		uint64_t w = words[i];
+		while (w != 0) {
+			uint64_t k = kbegin + 64 * i + __builtin_ctzll(w);
+			primes[n++] = 2 * k + 1;
+			w &= w - 1;
+		}
+	}
+	return n;
+}
+
+static uint64_t count_bits(const uint64_t *words, uint64_t nbits) {
+	uint64_t n = 0;
+	uint64_t nwords = (nbits + 63) / 64;
+	for (uint64_t i = 0; i < nwords; i++) {
+		n += __builtin_popcountll(words[i]);
+	}
+	return n;
+}
+
+// Each thread takes the next segment until there are none left.  With
+// a callback, the thread then waits for the segments before its own to
+// be delivered, so that the primes come out in order.
+static void *worker_main(void *arg) {
+	SieveWorker *worker = (SieveWorker *) arg;
+	SieveShared *shared = worker->shared;
+	const SieveParams *params = shared->params;
+
+	for (;;) {
+		pthread_mutex_lock(&shared->lock);
+		uint64_t s = shared->next_segment++;
+		pthread_mutex_unlock(&shared->lock);
+		if (s >= shared->nsegments) {
+			break;
+		}
+
+		uint64_t kbegin = shared->kstart + s * shared->segment_bits;
+		uint64_t nbits = shared->khi - kbegin;
+		if (nbits > shared->segment_bits) {
+			nbits = shared->segment_bits;
+		}
+		sieve_segment(shared, kbegin, nbits, worker->words);
+
+		if (params->callback == NULL) {
+			worker->count += count_bits(worker->words, nbits);
+			continue;
+		}
+
+		size_t n = list_primes(worker->words, kbegin, nbits, worker->primes);
+		worker->count += n;
+
+		pthread_mutex_lock(&shared->lock);
+		while (shared->delivered != s) {
+			pthread_cond_wait(&shared->turn, &shared->lock);
+		}
+		pthread_mutex_unlock(&shared->lock);
+
+		if (n > 0) {
+			params->callback(worker->primes, n, params->arg);
+		}
+
+		pthread_mutex_lock(&shared->lock);
+		shared->delivered++;
+		pthread_cond_broadcast(&shared->turn);
+		pthread_mutex_unlock(&shared->lock);
+	}
+	return NULL;
+}
+
+// Find the primes in lo..hi-1, with params->nthreads threads each
+// sieving segments of params->segment_kb KB.  They are passed to
+// params->callback in order (see PrimeCallback), unless it is NULL,
+// and *count is set to how many there are.  hi must be at most
+// SIEVE_MAX.
+// Returns false if memory could not be allocated (if a thread could
+// not be started, the others do its share).
+bool sieve_range(uint64_t lo, uint64_t hi, const SieveParams *params, uint64_t *count) {
+	*count = 0;
+	if (hi <= lo) {
+		return true;
+	}
+
+	SieveShared shared;
+	shared.params = params;
+	shared.klo = lo / 2;
+	shared.khi = hi / 2;
+	shared.kstart = shared.klo / 64 * 64;
+	shared.segment_bits = (uint64_t) params->segment_kb * 1024 * 8;
+	shared.nsegments = (shared.khi > shared.klo)
+		? (shared.khi - shared.kstart + shared.segment_bits - 1) / shared.segment_bits : 0;
+	shared.next_segment = 0;
+	shared.delivered = 0;
+
+	// base primes: the odd ones up to the square root of hi - 1
+	uint32_t root = (uint32_t) sqrtl((long double) (hi - 1));
+	while ((uint64_t) root * root > hi - 1) {
+		root--;
+	}
+	while ((uint64_t) (root + 1) * (root + 1) <= hi - 1) {
+		root++;
+	}
+	// (below the square of the next prime, the pre-sieve does it all)
+	size_t nbase = 0;
+	uint32_t *base = NULL;
+	if (root > presieve_primes[NUM_PRESIEVE-1]) {
+		base = small_primes(root, &nbase);
+		if (base == NULL) {
+			return false;
+		}
+	}
+	size_t skip = 1 + NUM_PRESIEVE;     // 2, then the pre-sieved primes
+	if (skip > nbase) {
+		skip = nbase;
+	}
+	shared.base = base + skip;
+	shared.nbase = nbase - skip;
+
+	uint64_t *presieve = make_presieve();
+	if (presieve == NULL) {
+		free(base);
+		return false;
+	}
+	shared.presieve = presieve;
+
+	int nthreads = params->nthreads;
+	if ((uint64_t) nthreads > shared.nsegments) {
+		nthreads = shared.nsegments > 0 ? (int) shared.nsegments : 1;
+	}
+
+	SieveWorker *workers = (SieveWorker *) calloc(nthreads, sizeof(SieveWorker));
+	bool ok = workers != NULL;
+	for (int t = 0; t < nthreads && ok; t++) {
+		workers[t].shared = &shared;
+		workers[t].words = (uint64_t *) malloc(shared.segment_bits / 8);
+		ok = workers[t].words != NULL;
+		if (ok && params->callback != NULL) {
+			// every bit could be a prime, in principle
+			workers[t].primes = (uint64_t *) malloc(shared.segment_bits * sizeof(uint64_t));
+			ok = workers[t].primes != NULL;
+		}
+	}
+
+	if (ok) {
+		// 2 is the one even prime
+		if (lo <= 2 && hi > 2) {
+			static const uint64_t two = 2;
+			if (params->callback != NULL) {
+				params->callback(&two, 1, params->arg);
+			}
+			*count = 1;
+		}
+
+		pthread_mutex_init(&shared.lock, NULL);
+		pthread_cond_init(&shared.turn, NULL);
+
+		int started = 0;
+		for (int t = 1; t < nthreads; t++) {
+			if (pthread_create(&workers[t].thread, NULL, worker_main, &workers[t]) != 0) {
+				break;
+			}
+			started++;
+		}
+		// the calling thread is worker 0
+		worker_main(&workers[0]);
+		for (int t = 1; t <= started; t++) {
+			pthread_join(workers[t].thread, NULL);
+		}
+
+		for (int t = 0; t < nthreads; t++) {
+			*count += workers[t].count;
+		}
+		pthread_mutex_destroy(&shared.lock);
+		pthread_cond_destroy(&shared.turn);
+	}
+
+	if (workers != NULL) {
+		for (int t = 0; t < nthreads; t++) {
+			free(workers[t].words);
+			free(workers[t].primes);
+		}
+	}
+	free(workers);
+	free(presieve);
+	free(base);
+	return ok;
+}
@@ -0,0 +1,34 @@
+#ifndef SIEVE_H
+#define SIEVE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Size of each thread's segment bit array unless one is given: one bit
+// per odd number, so 32 KB (which fits in a typical L1 data cache)
+// covers 524288 numbers
+#define SIEVE_SEGMENT_KB 32
+
+// Largest end of a range that can be sieved (the base primes up to
+// its square root must fit in 32 bits).  Near it, the list of base
+// primes (105 million of them) takes about 400 MB.
+#define SIEVE_MAX (1ULL << 62)
+
+// Called with the primes found in one segment, in increasing order.
+// The segments are passed in order, one call at a time, so the
+// callback sees all of the primes of the range in order.
+typedef void (*PrimeCallback)(const uint64_t *primes, size_t count, void *arg);
+
+// How to run a sieve
+struct SieveParams {
+	int nthreads;
+	int segment_kb;           // size of each segment's bit array
+	PrimeCallback callback;   // NULL to only count the primes
+	void *arg;                // passed to callback
+};
+
+void sieve_params_init(SieveParams *params);
+uint32_t *small_primes(uint32_t limit, size_t *count);
+bool sieve_range(uint64_t lo, uint64_t hi, const SieveParams *params, uint64_t *count);
+
+#endif // SIEVE_H
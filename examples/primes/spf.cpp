@@ -0,0 +1,198 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "spf.h"
+
+// Number of primes below 2^16, which are all the primes the sieve in
+// spf_build multiplies by
+#define PRIMES_BELOW_2_16 6542
+
+// Fill in the entries of a table (see SpfHeader) for the numbers below
+// limit, which must all be 0 to start with, by a linear sieve.
+//
+// Every odd composite c is p i for exactly one odd i and prime p: p is
+// the smallest prime factor of c, and then p is at most the smallest
+// prime factor of i.  So going through the odd i in order, and marking
+// p i for each prime p up to i's smallest prime factor, sets each
+// entry exactly once, unlike the sieve of Eratosthenes, which marks a
+// number once for every prime factor.  When i is reached, its entry is
+// already final, so an entry of 0 means i is prime.  The primes
+// multiplied by are at most the square root of limit, so only those
+// (less than 2^16) are kept.
+static void linear_sieve(uint16_t *spf, uint64_t limit) {
+	static uint32_t primes[PRIMES_BELOW_2_16];
+	int nprimes = 0;
+
+	for (uint64_t i = 3; i * 3 < limit; i += 2) {
+		uint64_t smallest = spf[i / 2];
+		if (smallest == 0) {
+			smallest = i;
+			if (i < (1 << 16)) {
+				primes[nprimes++] = i;
+			}
+		}
+		for (int j = 0; j < nprimes && primes[j] <= smallest; j++) {
+			uint64_t c = i * primes[j];
+			if (c >= limit) {
+				break;
+			}
+			spf[c / 2] = primes[j];
+		}
+	}
+}
+
+// Build the table for the numbers below limit (at most SPF_MAX) and
+// write it to a file; for limit = 10^9 it is 1 GB.  The sieve runs in
+// ordinary memory, and the table is copied into the file, mapped into
+// memory, when it is done.  (Sieving directly into the mapped file is
+// much slower: the kernel keeps writing pages out while the sieve is
+// still scattering writes over them.)
+// Returns false (after printing why) if memory could not be allocated
+// or the file could not be written.
+bool spf_build(const char *filename, uint64_t limit) {
+	size_t entries = limit / 2;
+	size_t table_size = entries * sizeof(uint16_t);
+	size_t file_size = sizeof(SpfHeader) + table_size;
+
+	// calloc gets fresh pages of zeros from the system, which is what
+	// the sieve needs to start with
+	uint16_t *spf = (uint16_t *) calloc(entries > 0 ? entries : 1, sizeof(uint16_t));
+	if (spf == NULL) {
+		printf("Not enough memory for a table of %llu numbers\n", (unsigned long long) limit);
+		return false;
+	}
+	linear_sieve(spf, limit);
+
+	int fd = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		perror(filename);
+		free(spf);
+		return false;
+	}
+	if (ftruncate(fd, file_size) != 0) {
+		perror(filename);
+		close(fd);
+		free(spf);
+		return false;
+	}
+
+	void *map = mmap(NULL, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		free(spf);
+		return false;
+	}
+
+	SpfHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "SPFT", 4);
+	header.version = SPF_FILE_VERSION;
+	header.limit = limit;
+	memcpy(map, &header, sizeof(header));
+	memcpy((char *) map + sizeof(header), spf, table_size);
+	free(spf);
+
+	bool ok = munmap(map, file_size) == 0;
+	if (!ok) {
+		perror(filename);
+	}
+	return ok;
+}
+
+// Map a table written by spf_build into memory, read-only.  Nothing is
+// read until it is looked up, so this takes no time however big the
+// table is, and the pages looked up stay in the page cache for the
+// next program that uses the table.
+// Returns false (after printing why) if the file can't be used.
+bool spf_open(SpfTable *t, const char *filename) {
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) {
+		perror(filename);
+		return false;
+	}
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(SpfHeader)) {
+		printf("%s: not a factor table\n", filename);
+		close(fd);
+		return false;
+	}
+	size_t file_size = st.st_size;
+
+	void *map = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		perror(filename);
+		return false;
+	}
+
+	SpfHeader header;
+	memcpy(&header, map, sizeof(header));
+	if (memcmp(header.magic, "SPFT", 4) != 0 || header.version != SPF_FILE_VERSION) {
+		printf("%s: not a factor table\n", filename);
+		munmap(map, file_size);
+		return false;
+	}
+	if (header.limit > SPF_MAX
+			|| file_size != sizeof(SpfHeader) + header.limit / 2 * sizeof(uint16_t)) {
+		printf("%s: table size doesn't match file size\n", filename);
+		munmap(map, file_size);
+		return false;
+	}
+
+	t->limit = header.limit;
+	t->spf = (const uint16_t *) ((const char *) map + sizeof(SpfHeader));
+	t->map = map;
+	t->map_size = file_size;
+	return true;
+}
+
+void spf_close(SpfTable *t) {
+	munmap(t->map, t->map_size);
+	t->map = NULL;
+	t->spf = NULL;
+}
+
+// The prime factorization of n, from the table: the factors of 2 are
+// shifted out, and then each lookup gives the smallest prime factor p
+// of what is left, which is divided by p for the next lookup.  That is
+// one lookup per prime factor (at most 31 below 2^32).
+// Returns false if n isn't below the table's limit.
+bool spf_factorize(const SpfTable *t, uint64_t n, Factorization *f) {
+	f->count = 0;
+	if (n >= t->limit) {
+		return false;
+	}
+	if (n <= 1) {
+		return true;
+	}
+
+	int twos = __builtin_ctzll(n);
+	if (twos > 0) {
+		f->prime[0] = 2;
+		f->exponent[0] = twos;
+		f->count = 1;
+		n >>= twos;
+	}
+
+	while (n > 1) {
+		uint64_t p = t->spf[n / 2];
+		if (p == 0) {
+			p = n;
+		}
+		n /= p;
+		if (f->count > 0 && f->prime[f->count-1] == p) {
+			f->exponent[f->count-1]++;
+		} else {
+			f->prime[f->count] = p;
+			f->exponent[f->count] = 1;
+			f->count++;
+		}
+	}
+	return true;
+}
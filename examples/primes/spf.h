@@ -0,0 +1,40 @@
+#ifndef SPF_H
+#define SPF_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "factor.h"
+
+// Largest limit a table can have: the smallest prime factor of every
+// odd composite below it is less than 2^16, so it fits in an entry
+#define SPF_MAX (1ULL << 32)
+
+// Header at the start of a smallest-prime-factor table file.  The
+// entries follow it directly, one 16-bit entry per odd number
+// (entry k is for 2k+1), in the machine's byte order: the smallest
+// prime factor of the number, or 0 if the number is prime (or 1).
+// Even numbers are left out, since their smallest prime factor is 2.
+// It is 64 bytes long, like the grid file header in ../plate.
+struct SpfHeader {
+	char magic[4];        // "SPFT"
+	uint32_t version;     // SPF_FILE_VERSION
+	uint64_t limit;       // the table covers the numbers below this
+	char pad[48];
+};
+
+#define SPF_FILE_VERSION 1
+
+// A table file mapped into memory
+struct SpfTable {
+	uint64_t limit;
+	const uint16_t *spf;  // the entries
+	void *map;
+	size_t map_size;
+};
+
+bool spf_build(const char *filename, uint64_t limit);
+bool spf_open(SpfTable *t, const char *filename);
+void spf_close(SpfTable *t);
+bool spf_factorize(const SpfTable *t, uint64_t n, Factorization *f);
+
+#endif // SPF_H
@@ -0,0 +1,65 @@
+// Build a table of the smallest prime factor of every number below a
+// limit, for factoring those numbers quickly.
+//
+//   spftable.exe [-n LIMIT] [-o FILE]
+//
+// The table covers the numbers below LIMIT (default 10^9, at most
+// 2^32; exponents like 1e9 are allowed) and is written to FILE
+// (default spf.bin).  It takes 1 byte per number, so 1 GB for the
+// default.  Then, for example,
+//
+//   ./factors.exe -t spf.bin -b < numbers.txt
+//
+// factors each number with a few lookups in the table (see spf.cpp).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "numparse.h"
+#include "spf.h"
+#include "timer.h"
+
+void usage(void);
+
+int main(int argc, char *argv[]) {
+	uint64_t limit = 1000000000;
+	const char *filename = "spf.bin";
+
+	for (int i = 1; i < argc; i++) {
+		if (i + 1 >= argc) {
+			usage();
+			return 1;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-n") == 0) {
+			if (!parse_number(value, &limit) || limit > SPF_MAX) {
+				usage();
+				return 1;
+			}
+		} else if (strcmp(argv[i], "-o") == 0) {
+			filename = value;
+		} else {
+			usage();
+			return 1;
+		}
+		i++;
+	}
+
+	double start = wall_time();
+	if (!spf_build(filename, limit)) {
+		return 1;
+	}
+	double seconds = wall_time() - start;
+
+	printf("Limit:      %llu\n", (unsigned long long) limit);
+	printf("File:       %s (%.1lf MB)\n", filename,
+		(sizeof(SpfHeader) + limit / 2 * sizeof(uint16_t)) / 1e6);
+	printf("Time:       %.3lf s\n", seconds);
+	return 0;
+}
+
+void usage(void) {
+	printf("Usage: spftable.exe [-n LIMIT] [-o FILE]\n");
+	printf("  -n LIMIT    cover the numbers below LIMIT (default 1e9, at most 2^32)\n");
+	printf("  -o FILE     write the table to FILE (default spf.bin)\n");
+}
@@ -0,0 +1,7 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+// Current wall clock time in seconds (only differences are meaningful)
+double wall_time(void);
+
+#endif // TIMER_H
@@ -0,0 +1,129 @@
+#include <math.h>
+#include "accumulator.h"
+
+void accumulator_init(Accumulator *a) {
+	a->count = 0;
+	a->sum = 0.0;
+	a->sum_error = 0.0;
+	a->min = INFINITY;
+	a->max = -INFINITY;
+	a->mean = 0.0;
+	a->m2 = 0.0;
+}
+
+// Add one value.
+//
+// The variance is not computed as (sum of x^2)/n - mean^2: with many
+// values, or values far from 0, those two terms are huge and nearly
+// equal, and subtracting them leaves mostly rounding error (even a
+// negative variance).  Welford's method instead keeps the mean and m2,
+// the sum of squared differences from the mean, up to date with each
+// value:
+//
+//   mean' = mean + (x - mean) / n
+//   m2'   = m2 + (x - mean) (x - mean')
+//
+// The sum uses Neumaier's compensated summation: the part of each
+// value lost to rounding when it is added is collected separately.
+void accumulator_add(Accumulator *a, double x) {
+	a->count++;
+
+	double sum = a->sum + x;
+	if (fabs(a->sum) >= fabs(x)) {
+		a->sum_error += (a->sum - sum) + x;
+	} else {
+		a->sum_error += (x - sum) + a->sum;
+	}
+	a->sum = sum;
+
+	if (x < a->min) {
+		a->min = x;
+	}
+	if (x > a->max) {
+		a->max = x;
+	}
+
+	double delta = x - a->mean;
+	a->mean += delta / a->count;
+	a->m2 += delta * (x - a->mean);
+}
+
+// Add n values at once, with the reductions in kernels (see
+// reduce.cpp): their own sum, min, max and mean are found in one pass,
+// and their m2 in a second one while they are still in the cache, and
+// the summary of them is merged into a.  This is much faster than
+// adding the values one at a time, which divides for each of them.
+void accumulator_add_values(Accumulator *a, const double *values, size_t n,
+		const ReduceKernels *kernels) {
+	if (n == 0) {
+		return;
+	}
+	DoubleStats s;
+	double_stats_init(&s);
+	kernels->double_stats(values, n, &s);
+
+	Accumulator b;
+	b.count = n;
+	b.sum = s.sum;
+	b.sum_error = 0.0;
+	b.min = s.min;
+	b.max = s.max;
+	b.mean = s.sum / n;
+	b.m2 = kernels->squared_deviations(values, n, b.mean);
+	accumulator_merge(a, &b);
+}
+
+// Add the values summarized by b to a, as if they had been added one
+// at a time.  The means and m2s are combined (Chan, Golub and
+// LeVeque), with delta the difference between the two means and n'
+// the new count:
+//
+//   mean' = mean + delta n_b / n'
+//   m2'   = m2 + m2_b + delta^2 n n_b / n'
+//
+// Merging is associative (up to rounding), so a set of values can be
+// split into parts in any way, each part summarized on its own, and
+// the summaries merged.
+void accumulator_merge(Accumulator *a, const Accumulator *b) {
+	if (b->count == 0) {
+		return;
+	}
+	long count = a->count + b->count;
+	double delta = b->mean - a->mean;
+	a->mean += delta * b->count / count;
+	a->m2 += b->m2 + delta * delta * ((double) a->count * b->count / count);
+	a->count = count;
+
+	double sum = a->sum + b->sum;
+	if (fabs(a->sum) >= fabs(b->sum)) {
+		a->sum_error += (a->sum - sum) + b->sum;
+	} else {
+		a->sum_error += (b->sum - sum) + a->sum;
+	}
+	a->sum = sum;
+	a->sum_error += b->sum_error;
+
+	if (b->min < a->min) {
+		a->min = b->min;
+	}
+	if (b->max > a->max) {
+		a->max = b->max;
+	}
+}
+
+double accumulator_sum(const Accumulator *a) {
+	return a->sum + a->sum_error;
+}
+
+// The variance of the values (the mean squared difference from the
+// mean), or 0 if there are none
+double accumulator_variance(const Accumulator *a) {
+	return (a->count > 0) ? a->m2 / a->count : 0.0;
+}
+
+// The sample variance, which divides by n - 1 instead of n to estimate
+// the variance of a population that the values are a sample of, or 0
+// if there are fewer than 2 values
+double accumulator_sample_variance(const Accumulator *a) {
+	return (a->count > 1) ? a->m2 / (a->count - 1) : 0.0;
+}
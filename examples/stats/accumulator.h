@@ -0,0 +1,32 @@
+#ifndef ACCUMULATOR_H
+#define ACCUMULATOR_H
+
+#include <stddef.h>
+#include "reduce.h"
+
+// Statistics of a stream of values, in constant memory: each value is
+// added as it arrives, and none of them are kept.  The mean and
+// variance are updated with Welford's method (see accumulator.cpp),
+// so they stay accurate over millions of values, and the sum is a
+// double with its rounding error carried along, so it neither
+// overflows like an int nor drifts.
+struct Accumulator {
+	long count;
+	double sum;
+	double sum_error;     // rounding error of sum, added back at the end
+	double min;
+	double max;
+	double mean;
+	double m2;            // sum of squared differences from the mean
+};
+
+void accumulator_init(Accumulator *a);
+void accumulator_add(Accumulator *a, double x);
+void accumulator_add_values(Accumulator *a, const double *values, size_t n,
+	const ReduceKernels *kernels);
+void accumulator_merge(Accumulator *a, const Accumulator *b);
+double accumulator_sum(const Accumulator *a);
+double accumulator_variance(const Accumulator *a);
+double accumulator_sample_variance(const Accumulator *a);
+
+#endif // ACCUMULATOR_H
@@ -0,0 +1,283 @@
+// The statistics of random-array-stats.cpp, for an array of any size.
+//
+//   arraystats.exe [-n SIZE] [-r SEED] [-s scalar|avx2|auto] [-j THREADS] [-b]
+//
+// Fills an array with SIZE (default 100) random ints from 1 to 1000,
+// seeded with SEED (default the time), and prints the same as
+// random-array-stats.cpp: the mean, min and max, the average and count
+// of the even and the odd values and of the values at even and odd
+// positions, and how many values are within 50% of the mean, and then
+// the variance.  SIZE can be written with an exponent, e.g. -n 1e8.
+//
+// The statistics are taken with the reductions in reduce.cpp, for the
+// instruction set chosen with -s (default the widest the CPU has), by
+// THREADS threads (default 1) each summarizing a slice of the array
+// (see parallel.cpp).  -b also times the loops of
+// random-array-stats.cpp and each of the instruction sets on the same
+// array, and checks that they agree:
+//
+//   ./arraystats.exe -n 1e8 -j 4 -b
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "numparse.h"
+#include "parallel.h"
+#include "timer.h"
+
+#define MIN_RAND 1      // minimum random #
+#define MAX_RAND 1000   // maximum random #
+
+struct Options {
+	uint64_t size;
+	unsigned seed;
+	ReduceParams params;
+	bool bench;
+};
+
+bool parse_options(int argc, char *argv[], Options *opts);
+void usage(void);
+bool loop_stats(const int32_t *data, size_t n, IntSummary *stats);
+void print_stats(const IntSummary *stats);
+bool same_stats(const IntSummary *a, const IntSummary *b);
+bool bench(const int32_t *data, size_t n, const ReduceParams *params);
+
+int main(int argc, char *argv[]) {
+	Options opts;
+	if (!parse_options(argc, argv, &opts)) {
+		usage();
+		return 1;
+	}
+
+	size_t n = opts.size;
+	int32_t *data = (int32_t *) malloc(n * sizeof(int32_t));
+	if (data == NULL) {
+		printf("Not enough memory for %llu values\n", (unsigned long long) n);
+		return 1;
+	}
+	srand(opts.seed);
+	for (size_t i = 0; i < n; i++) {
+		data[i] = rand() % MAX_RAND + MIN_RAND;
+	}
+
+	IntSummary stats;
+	if (!summarize_ints(data, n, &opts.params, &stats)) {
+		printf("Not enough memory for %i threads\n", opts.params.nthreads);
+		free(data);
+		return 1;
+	}
+	print_stats(&stats);
+
+	bool ok = true;
+	if (opts.bench) {
+		ok = bench(data, n, &opts.params);
+	}
+	free(data);
+	return ok ? 0 : 1;
+}
+
+bool parse_options(int argc, char *argv[], Options *opts) {
+	opts->size = 100;
+	opts->seed = time(0);
+	reduce_params_init(&opts->params);
+	opts->bench = false;
+
+	for (int i = 1; i < argc; i++) {
+		// options without a value
+		if (strcmp(argv[i], "-b") == 0) {
+			opts->bench = true;
+			continue;
+		}
+
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-n") == 0) {
+			if (!parse_number(value, &opts->size)) {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-r") == 0) {
+			opts->seed = strtoul(value, NULL, 10);
+		} else if (strcmp(argv[i], "-s") == 0) {
+			if (strcmp(value, "scalar") == 0) {
+				opts->params.simd = SIMD_SCALAR;
+			} else if (strcmp(value, "avx2") == 0) {
+				opts->params.simd = SIMD_AVX2;
+			} else if (strcmp(value, "auto") == 0) {
+				opts->params.simd = SIMD_AUTO;
+			} else {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			opts->params.nthreads = atoi(value);
+		} else {
+			return false;
+		}
+		i++;
+	}
+	// (the array's size in bytes must fit in a size_t)
+	return opts->size >= 1 && opts->size <= SIZE_MAX / sizeof(int32_t)
+		&& opts->params.nthreads >= 1;
+}
+
+void usage(void) {
+	printf("Usage: arraystats.exe [-n SIZE] [-r SEED] [-s scalar|avx2|auto] [-j THREADS] [-b]\n");
+	printf("  -n SIZE     number of random values (default 100)\n");
+	printf("  -r SEED     seed for the random numbers (default the time)\n");
+	printf("  -s SIMD     instruction set for the statistics (default: widest supported)\n");
+	printf("  -j THREADS  number of threads taking the statistics (default 1)\n");
+	printf("  -b          time the loops of random-array-stats.cpp and each instruction set\n");
+}
+
+// The same statistics, taken with the loops of random-array-stats.cpp
+// (a pass for each, branching on each value, and copying the even and
+// odd values out to arrays of their own), for comparison.  Only the
+// sum is changed from an int to an int64_t, since with more than a few
+// million values an int overflows.
+// Returns false if there isn't enough memory for the copies.
+bool loop_stats(const int32_t *data, size_t n, IntSummary *stats) {
+	int32_t *odds = (int32_t *) malloc(n * sizeof(int32_t));
+	int32_t *evens = (int32_t *) malloc(n * sizeof(int32_t));
+	if (odds == NULL || evens == NULL) {
+		free(odds);
+		free(evens);
+		return false;
+	}
+
+	int64_t sum = 0;
+	for (size_t i = 0; i < n; i++) {
+		sum += data[i];
+	}
+	double mean = (double) sum / n;
+
+	int32_t min = INT32_MAX;
+	int32_t max = INT32_MIN;
+	for (size_t i = 0; i < n; i++) {
+		if (data[i] < min) {
+			min = data[i];
+		}
+		if (data[i] > max) {
+			max = data[i];
+		}
+	}
+
+	int64_t odd_count = 0;
+	int64_t even_count = 0;
+	double odd_vals = 0.0;
+	double even_vals = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		if (data[i] % 2 == 0) {
+			even_vals += data[i];
+			evens[even_count] = data[i];
+			even_count++;
+		} else {
+			odd_vals += data[i];
+			odds[odd_count] = data[i];
+			odd_count++;
+		}
+	}
+
+	double odd_locs = 0.0;
+	double even_locs = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		if (i % 2 == 0) {
+			even_locs += data[i];
+		} else {
+			odd_locs += data[i];
+		}
+	}
+
+	int64_t count = 0;
+	for (size_t i = 0; i < n; i++) {
+		if ((data[i] >= (mean * 0.50)) && (data[i] <= mean * 1.5)) {
+			count++;
+		}
+	}
+
+	double m2 = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		m2 += (data[i] - mean) * (data[i] - mean);
+	}
+
+	stats->ints.count = n;
+	stats->ints.sum = sum;
+	stats->ints.min = min;
+	stats->ints.max = max;
+	stats->ints.evens = even_count;
+	stats->ints.even_sum = (int64_t) even_vals;
+	stats->ints.even_position_sum = (int64_t) even_locs;
+	stats->m2 = m2;
+	stats->near_mean = count;
+	free(odds);
+	free(evens);
+	return true;
+}
+
+// Print the statistics the way random-array-stats.cpp does.
+void print_stats(const IntSummary *stats) {
+	const IntStats *s = &stats->ints;
+	int64_t odds = s->count - s->evens;
+	int64_t even_positions = (s->count + 1) / 2;
+	int64_t odd_positions = s->count / 2;
+
+	printf("mean = %0.2lf\n", (double) s->sum / s->count);
+	printf("min: %i\n", s->min);
+	printf("max: %i\n", s->max);
+	printf("even vals: %0.2lf (%lli)\n", s->evens > 0 ? (double) s->even_sum / s->evens : 0.0,
+		(long long) s->evens);
+	printf("odd vals:  %0.2lf (%lli)\n", odds > 0 ? (double) (s->sum - s->even_sum) / odds : 0.0,
+		(long long) odds);
+	printf("even locations: %0.2lf (%lli)\n", (double) s->even_position_sum / even_positions,
+		(long long) even_positions);
+	printf("odd locations:  %0.2lf (%lli)\n",
+		odd_positions > 0 ? (double) (s->sum - s->even_position_sum) / odd_positions : 0.0,
+		(long long) odd_positions);
+	printf("# of values within +/- 50%% of mean: %lli\n", (long long) stats->near_mean);
+	printf("variance = %0.2lf\n", stats->m2 / s->count);
+}
+
+// Whether two summaries are the same (the m2s only to 9 digits, since
+// they are added up in different orders)
+bool same_stats(const IntSummary *a, const IntSummary *b) {
+	return a->ints.count == b->ints.count && a->ints.sum == b->ints.sum
+		&& a->ints.min == b->ints.min && a->ints.max == b->ints.max
+		&& a->ints.evens == b->ints.evens && a->ints.even_sum == b->ints.even_sum
+		&& a->ints.even_position_sum == b->ints.even_position_sum
+		&& a->near_mean == b->near_mean && fabs(a->m2 - b->m2) <= 1e-9 * b->m2;
+}
+
+// Time the loops and the reductions for each instruction set, with
+// params->nthreads threads.
+// Returns false if they don't all get the same statistics.
+bool bench(const int32_t *data, size_t n, const ReduceParams *params) {
+	printf("\n");
+	IntSummary expected;
+	double start = wall_time();
+	if (!loop_stats(data, n, &expected)) {
+		printf("Not enough memory to time the loops\n");
+		return false;
+	}
+	double loop_time = wall_time() - start;
+	printf("loops:      %.3lf s\n", loop_time);
+
+	bool ok = true;
+	for (int level = SIMD_SCALAR; level <= simd_best(); level++) {
+		ReduceParams level_params = *params;
+		level_params.simd = level;
+		IntSummary stats;
+		start = wall_time();
+		if (!summarize_ints(data, n, &level_params, &stats)) {
+			printf("Not enough memory for %i threads\n", params->nthreads);
+			return false;
+		}
+		double time = wall_time() - start;
+		bool same = same_stats(&stats, &expected);
+		printf("%-8s    %.3lf s (%.1lfx faster)%s\n", simd_name(level), time, loop_time / time,
+			same ? "" : ", DIFFERENT");
+		ok = ok && same;
+	}
+	return ok;
+}
@@ -0,0 +1,23 @@
+#include <errno.h>
+#include <stdlib.h>
+#include "numparse.h"
+
+// Read a whole number from the command line, given either in digits or
+// as a power of ten (like 1e8, or 2.5e7).
+// Returns false if text isn't such a number, or it doesn't fit in 64 bits.
+bool parse_number(const char *text, uint64_t *n) {
+	char *end;
+	errno = 0;
+	unsigned long long value = strtoull(text, &end, 10);
+	if (*end == '\0' && end != text && text[0] != '-' && errno != ERANGE) {
+		*n = value;
+		return true;
+	}
+
+	double d = strtod(text, &end);
+	if (*end != '\0' || end == text || d < 0.0 || d > 1.8e19 || d != (double) (uint64_t) d) {
+		return false;
+	}
+	*n = (uint64_t) d;
+	return true;
+}
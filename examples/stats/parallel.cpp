@@ -0,0 +1,221 @@
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include "parallel.h"
+
+// Summaries of big arrays, split among threads.  Each thread takes one
+// slice of the array (every value is the same amount of work, so equal
+// slices take equal time) and builds a partial summary of it, with the
+// reductions in reduce.cpp.  The partial summaries are then merged, in
+// the order of the slices, into the summary of the whole array.  The
+// merges are associative, so the result doesn't depend on how many
+// slices there are, apart from rounding in the sums of doubles.
+//
+// The count within 50% of the mean can't be merged that way: whether a
+// value is counted depends on the mean of the whole array, which isn't
+// known until every slice has been summarized.  So it takes a second
+// phase, as it takes a second loop in random-array-stats.cpp: once the
+// partial summaries are merged, the threads are started again, each
+// counts the values of its slice between the bounds set by the mean,
+// and the counts are added up.  For ints, the sum of squared
+// differences from the mean is found in the same pass, which is more
+// accurate than merging the m2s of the slices.
+
+// State shared by the threads summarizing one array
+struct ReduceShared {
+	const int32_t *ints;        // the array, one of the two
+	const double *doubles;
+	const ReduceKernels *kernels;
+	size_t block_size;
+
+	// for the second phase
+	double mean;
+	int32_t int_lo, int_hi;     // empty if lo > hi
+	double lo, hi;
+};
+
+// One thread's slice, and its summary of it
+struct ReduceWorker {
+	pthread_t thread;
+	bool started;
+	const ReduceShared *shared;
+	size_t begin;
+	size_t end;
+	IntStats ints;
+	Accumulator acc;
+	double m2;
+	int64_t near_mean;
+};
+
+void reduce_params_init(ReduceParams *params) {
+	params->nthreads = 1;
+	params->block_size = REDUCE_BLOCK;
+	params->simd = SIMD_AUTO;
+}
+
+static void *int_stats_main(void *arg) {
+	ReduceWorker *worker = (ReduceWorker *) arg;
+	const ReduceShared *shared = worker->shared;
+	int_stats_init(&worker->ints);
+	shared->kernels->int_stats(&shared->ints[worker->begin], worker->end - worker->begin,
+		&worker->ints);
+	return NULL;
+}
+
+static void *int_near_mean_main(void *arg) {
+	ReduceWorker *worker = (ReduceWorker *) arg;
+	const ReduceShared *shared = worker->shared;
+	const int32_t *data = &shared->ints[worker->begin];
+	size_t n = worker->end - worker->begin;
+	worker->near_mean = 0;
+	if (shared->int_lo <= shared->int_hi) {
+		worker->near_mean = shared->kernels->int_count_between(data, n, shared->int_lo,
+			shared->int_hi);
+	}
+	worker->m2 = shared->kernels->int_squared_deviations(data, n, shared->mean);
+	return NULL;
+}
+
+static void *double_stats_main(void *arg) {
+	ReduceWorker *worker = (ReduceWorker *) arg;
+	const ReduceShared *shared = worker->shared;
+	accumulator_init(&worker->acc);
+	for (size_t i = worker->begin; i < worker->end; i += shared->block_size) {
+		size_t count = shared->block_size;
+		if (count > worker->end - i) {
+			count = worker->end - i;
+		}
+		accumulator_add_values(&worker->acc, &shared->doubles[i], count, shared->kernels);
+	}
+	return NULL;
+}
+
+static void *double_near_mean_main(void *arg) {
+	ReduceWorker *worker = (ReduceWorker *) arg;
+	const ReduceShared *shared = worker->shared;
+	worker->near_mean = shared->kernels->double_count_between(&shared->doubles[worker->begin],
+		worker->end - worker->begin, shared->lo, shared->hi);
+	return NULL;
+}
+
+// Split n values into slices for (at most) nthreads workers, setting
+// *nworkers to how many there are.
+// Returns NULL if memory could not be allocated.
+static ReduceWorker *make_workers(const ReduceShared *shared, size_t n, int nthreads,
+		int *nworkers) {
+	if ((size_t) nthreads > n) {
+		nthreads = n > 0 ? (int) n : 1;
+	}
+	ReduceWorker *workers = (ReduceWorker *) calloc(nthreads, sizeof(ReduceWorker));
+	if (workers == NULL) {
+		return NULL;
+	}
+	for (int t = 0; t < nthreads; t++) {
+		workers[t].shared = shared;
+		workers[t].begin = n / nthreads * t + n % nthreads * t / nthreads;
+		workers[t].end = n / nthreads * (t + 1) + n % nthreads * (t + 1) / nthreads;
+	}
+	*nworkers = nthreads;
+	return workers;
+}
+
+// Run main for every worker: worker 0 in the calling thread, and the
+// others in threads of their own.  If a thread can't be started, the
+// calling thread runs its worker too.
+static void run_workers(ReduceWorker *workers, int nworkers, void *(*main)(void *)) {
+	for (int t = 1; t < nworkers; t++) {
+		workers[t].started = pthread_create(&workers[t].thread, NULL, main, &workers[t]) == 0;
+	}
+	main(&workers[0]);
+	for (int t = 1; t < nworkers; t++) {
+		if (workers[t].started) {
+			pthread_join(workers[t].thread, NULL);
+		} else {
+			main(&workers[t]);
+		}
+	}
+}
+
+// Summarize the n ints of data, with params->nthreads threads.
+// Returns false if memory could not be allocated.
+bool summarize_ints(const int32_t *data, size_t n, const ReduceParams *params,
+		IntSummary *summary) {
+	ReduceShared shared;
+	shared.ints = data;
+	shared.doubles = NULL;
+	shared.kernels = reduce_kernels(params->simd);
+	shared.block_size = params->block_size;
+
+	int nworkers;
+	ReduceWorker *workers = make_workers(&shared, n, params->nthreads, &nworkers);
+	if (workers == NULL) {
+		return false;
+	}
+
+	run_workers(workers, nworkers, int_stats_main);
+	int_stats_init(&summary->ints);
+	for (int t = 0; t < nworkers; t++) {
+		int_stats_merge(&summary->ints, &workers[t].ints);
+	}
+
+	summary->m2 = 0.0;
+	summary->near_mean = 0;
+	if (n > 0) {
+		// The ints from mean/2 to 1.5 mean, as far as there are any.  If
+		// the mean is negative, mean/2 is the bigger bound, and none are.
+		shared.mean = (double) summary->ints.sum / n;
+		double lo = ceil(shared.mean * 0.5), hi = floor(shared.mean * 1.5);
+		shared.int_lo = 1;
+		shared.int_hi = 0;
+		if (shared.mean >= 0.0) {
+			shared.int_lo = (int32_t) lo;
+			shared.int_hi = (hi > INT32_MAX) ? INT32_MAX : (int32_t) hi;
+		}
+
+		run_workers(workers, nworkers, int_near_mean_main);
+		for (int t = 0; t < nworkers; t++) {
+			summary->m2 += workers[t].m2;
+			summary->near_mean += workers[t].near_mean;
+		}
+	}
+	free(workers);
+	return true;
+}
+
+// Summarize the n doubles of data, with params->nthreads threads each
+// adding params->block_size values at a time to their accumulators.
+// Returns false if memory could not be allocated.
+bool summarize_doubles(const double *data, size_t n, const ReduceParams *params,
+		DoubleSummary *summary) {
+	ReduceShared shared;
+	shared.ints = NULL;
+	shared.doubles = data;
+	shared.kernels = reduce_kernels(params->simd);
+	shared.block_size = params->block_size;
+
+	int nworkers;
+	ReduceWorker *workers = make_workers(&shared, n, params->nthreads, &nworkers);
+	if (workers == NULL) {
+		return false;
+	}
+
+	run_workers(workers, nworkers, double_stats_main);
+	accumulator_init(&summary->acc);
+	for (int t = 0; t < nworkers; t++) {
+		accumulator_merge(&summary->acc, &workers[t].acc);
+	}
+
+	summary->near_mean = 0;
+	if (n > 0) {
+		// (if the mean is negative, lo > hi and none are counted)
+		shared.mean = summary->acc.mean;
+		shared.lo = shared.mean * 0.5;
+		shared.hi = shared.mean * 1.5;
+		run_workers(workers, nworkers, double_near_mean_main);
+		for (int t = 0; t < nworkers; t++) {
+			summary->near_mean += workers[t].near_mean;
+		}
+	}
+	free(workers);
+	return true;
+}
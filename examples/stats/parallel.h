@@ -0,0 +1,41 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "accumulator.h"
+#include "reduce.h"
+
+// Values of an array of doubles a thread adds to its accumulator at a
+// time, unless a size is given (4096 doubles fill half of a typical L1
+// cache, so the second pass over them, for m2, reads from the cache)
+#define REDUCE_BLOCK 4096
+
+// How to summarize an array
+struct ReduceParams {
+	int nthreads;
+	size_t block_size;   // values per accumulator_add_values, for doubles
+	int simd;            // a SimdLevel
+};
+
+// Everything random-array-stats.cpp and quiz_stats.cpp print about an
+// array of ints, and the variance
+struct IntSummary {
+	IntStats ints;
+	double m2;           // sum of squared differences from the mean
+	int64_t near_mean;   // values within 50% of the mean
+};
+
+// The same for an array of doubles
+struct DoubleSummary {
+	Accumulator acc;
+	int64_t near_mean;   // values within 50% of the mean
+};
+
+void reduce_params_init(ReduceParams *params);
+bool summarize_ints(const int32_t *data, size_t n, const ReduceParams *params,
+	IntSummary *summary);
+bool summarize_doubles(const double *data, size_t n, const ReduceParams *params,
+	DoubleSummary *summary);
+
+#endif // PARALLEL_H
@@ -0,0 +1,151 @@
+// Time reading numbers with scanf against reading them with a
+// ValueReader.
+//
+//   readbench.exe [-i] FILE...
+//
+// Each FILE is read three ways: with an fscanf("%lf") for each number
+// (or "%d" with -i), as read_data in values.cpp, read_values in
+// values2.cpp and the loop in quiz_stats.cpp do; with a ValueReader
+// reading the file in blocks; and with one mapping it into memory (see
+// valread.cpp).  For each, the speed is printed in MB of text per
+// second, and the numbers read are checked to be the same.  For
+// example
+//
+//   awk 'BEGIN { for (i = 0; i < 1e7; i++) print rand() * 100 }' > values.txt
+//   ./readbench.exe values.txt
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "timer.h"
+#include "valread.h"
+
+// The ways of reading a file
+enum ReadMethod {
+	READ_SCANF,
+	READ_BLOCKS,
+	READ_MAPPED
+};
+
+static const char *method_names[] = { "scanf", "blocks", "mapped" };
+
+// What was read: how many numbers, and a hash of them all (of their
+// bits, for doubles), to check that two ways read the same numbers
+struct ReadResult {
+	long count;
+	uint64_t hash;
+};
+
+bool read_file(const char *name, int method, bool ints, ReadResult *result);
+void add_value(ReadResult *result, uint64_t bits);
+
+int main(int argc, char *argv[]) {
+	bool ints = false;
+	int first = 1;
+	if (argc > 1 && strcmp(argv[1], "-i") == 0) {
+		ints = true;
+		first = 2;
+	}
+	if (first >= argc) {
+		printf("Usage: readbench.exe [-i] FILE...\n");
+		printf("  FILE...     files of numbers to read\n");
+		printf("  -i          read them as ints instead of doubles\n");
+		return 1;
+	}
+
+	int status = 0;
+	for (int i = first; i < argc; i++) {
+		struct stat st;
+		if (stat(argv[i], &st) != 0) {
+			printf("Can't read %s\n", argv[i]);
+			status = 1;
+			continue;
+		}
+		double mb = st.st_size / 1e6;
+		printf("%s: %.1lf MB\n", argv[i], mb);
+
+		ReadResult expected;
+		for (int method = READ_SCANF; method <= READ_MAPPED; method++) {
+			ReadResult result;
+			double start = wall_time();
+			if (!read_file(argv[i], method, ints, &result)) {
+				status = 1;
+				break;
+			}
+			double time = wall_time() - start;
+			printf("  %-8s  %9.1lf MB/s  %.3lf s  %li numbers", method_names[method],
+				mb / time, time, result.count);
+			if (method == READ_SCANF) {
+				expected = result;
+			} else if (result.count != expected.count || result.hash != expected.hash) {
+				printf(", DIFFERENT");
+				status = 1;
+			}
+			printf("\n");
+		}
+	}
+	return status;
+}
+
+// Read every number in a file, as an int or a double, one of the ways.
+// Returns false (after printing what was wrong) if it can't be read or
+// has something that isn't a number.
+bool read_file(const char *name, int method, bool ints, ReadResult *result) {
+	FILE *file = fopen(name, "r");
+	if (file == NULL) {
+		printf("Can't read %s\n", name);
+		return false;
+	}
+	result->count = 0;
+	result->hash = 0;
+
+	int got;
+	if (method == READ_SCANF) {
+		if (ints) {
+			int x;
+			while ((got = fscanf(file, "%d", &x)) == 1) {
+				add_value(result, (uint64_t) x);
+			}
+		} else {
+			double x;
+			while ((got = fscanf(file, "%lf", &x)) == 1) {
+				uint64_t bits;
+				memcpy(&bits, &x, sizeof(bits));
+				add_value(result, bits);
+			}
+		}
+		if (got != EOF) {
+			printf("%s: not a number\n", name);
+		}
+		got = (got == EOF) ? 0 : -1;
+	} else {
+		ValueReader reader;
+		value_reader_init(&reader, file, name);
+		if (method == READ_MAPPED && !value_reader_map(&reader)) {
+			printf("Can't map %s\n", name);
+			fclose(file);
+			return false;
+		}
+		if (ints) {
+			int64_t x;
+			while ((got = value_reader_next_int(&reader, &x)) == 1) {
+				add_value(result, (uint64_t) (int) x);
+			}
+		} else {
+			double x;
+			while ((got = value_reader_next_double(&reader, &x)) == 1) {
+				uint64_t bits;
+				memcpy(&bits, &x, sizeof(bits));
+				add_value(result, bits);
+			}
+		}
+		value_reader_close(&reader);
+	}
+	fclose(file);
+	return got == 0;
+}
+
+void add_value(ReadResult *result, uint64_t bits) {
+	result->count++;
+	result->hash = (result->hash ^ bits) * 0x100000001b3ULL;
+}
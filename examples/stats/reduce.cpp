@@ -0,0 +1,382 @@
+#include <math.h>
+#include "reduce.h"
+
+// The loops in random-array-stats.cpp test each value with an if: is
+// it even, is it smaller than the min so far.  On random data the CPU
+// guesses wrong about half the time and has to back up, which costs
+// more than the rest of the loop.  The kernels here never branch on
+// the data: the even test becomes a mask (x & 1) - 1, which is all
+// ones for an even x and 0 for an odd one, and is ANDed with x to add
+// either x or 0.  Min and max compile to conditional moves, or to
+// vector min/max instructions.  All the statistics are also taken in
+// a single pass over the array instead of one pass each.
+//
+// The vector kernels (AVX2, 8 ints or 4 doubles at a time) keep one
+// sum, min, max or count per lane and combine the lanes at the end.
+// The int sums are kept as 64-bit numbers, so they can't overflow.
+
+// Each lane's 32-bit count is added to the total after this many
+// vectors, before it can overflow
+#define LANE_COUNT_BLOCK ((size_t) 1 << 30)
+
+void int_stats_init(IntStats *s) {
+	s->count = 0;
+	s->sum = 0;
+	s->min = INT32_MAX;
+	s->max = INT32_MIN;
+	s->evens = 0;
+	s->even_sum = 0;
+	s->even_position_sum = 0;
+}
+
+// Add to a the statistics b of the array that follows a's.  The
+// positions in b count from the start of its own array, so when a's
+// array has an odd length, b's even positions are odd ones of the two
+// arrays together.  Merging is associative, like the addition of the
+// arrays it stands for.
+void int_stats_merge(IntStats *a, const IntStats *b) {
+	if (a->count % 2 == 0) {
+		a->even_position_sum += b->even_position_sum;
+	} else {
+		a->even_position_sum += b->sum - b->even_position_sum;
+	}
+	a->count += b->count;
+	a->sum += b->sum;
+	a->min = (b->min < a->min) ? b->min : a->min;
+	a->max = (b->max > a->max) ? b->max : a->max;
+	a->evens += b->evens;
+	a->even_sum += b->even_sum;
+}
+
+void double_stats_init(DoubleStats *s) {
+	s->count = 0;
+	s->sum = 0.0;
+	s->min = INFINITY;
+	s->max = -INFINITY;
+}
+
+static void int_stats_scalar(const int32_t *data, size_t n, IntStats *s) {
+	int64_t sum = 0, evens = 0, even_sum = 0, even_position_sum = 0;
+	int32_t min = s->min, max = s->max;
+	for (size_t i = 0; i < n; i++) {
+		int32_t x = data[i];
+		sum += x;
+		min = (x < min) ? x : min;
+		max = (x > max) ? x : max;
+		int32_t even = (x & 1) - 1;
+		evens -= even;
+		even_sum += x & even;
+		even_position_sum += x & (int32_t) ((i & 1) - 1);
+	}
+	s->count += n;
+	s->sum += sum;
+	s->min = min;
+	s->max = max;
+	s->evens += evens;
+	s->even_sum += even_sum;
+	s->even_position_sum += even_position_sum;
+}
+
+static int64_t int_count_between_scalar(const int32_t *data, size_t n, int32_t lo, int32_t hi) {
+	int64_t count = 0;
+	for (size_t i = 0; i < n; i++) {
+		count += (data[i] >= lo) & (data[i] <= hi);
+	}
+	return count;
+}
+
+static double int_squared_deviations_scalar(const int32_t *data, size_t n, double mean) {
+	double sum = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		double d = data[i] - mean;
+		sum += d * d;
+	}
+	return sum;
+}
+
+static void double_stats_scalar(const double *data, size_t n, DoubleStats *s) {
+	double sum = 0.0;
+	double min = s->min, max = s->max;
+	for (size_t i = 0; i < n; i++) {
+		double x = data[i];
+		sum += x;
+		min = (x < min) ? x : min;
+		max = (x > max) ? x : max;
+	}
+	s->count += n;
+	s->sum += sum;
+	s->min = min;
+	s->max = max;
+}
+
+static int64_t double_count_between_scalar(const double *data, size_t n, double lo, double hi) {
+	int64_t count = 0;
+	for (size_t i = 0; i < n; i++) {
+		count += (data[i] >= lo) & (data[i] <= hi);
+	}
+	return count;
+}
+
+static double squared_deviations_scalar(const double *data, size_t n, double mean) {
+	double sum = 0.0;
+	for (size_t i = 0; i < n; i++) {
+		double d = data[i] - mean;
+		sum += d * d;
+	}
+	return sum;
+}
+
+static const ReduceKernels scalar_kernels = {
+	int_stats_scalar,
+	int_count_between_scalar,
+	int_squared_deviations_scalar,
+	double_stats_scalar,
+	double_count_between_scalar,
+	squared_deviations_scalar,
+};
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define HAVE_X86_SIMD
+#include <immintrin.h>
+
+// Sum of the 64-bit lanes
+__attribute__((target("avx2")))
+static int64_t sum_lanes(__m256i v) {
+	int64_t lanes[4];
+	_mm256_storeu_si256((__m256i *) lanes, v);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// Sum of the 32-bit lanes, each taken as a count from 0 to 2^32 - 1
+__attribute__((target("avx2")))
+static int64_t sum_counts(__m256i v) {
+	uint32_t lanes[8];
+	_mm256_storeu_si256((__m256i *) lanes, v);
+	int64_t sum = 0;
+	for (int k = 0; k < 8; k++) {
+		sum += lanes[k];
+	}
+	return sum;
+}
+
+// _mm256_mul_epi32 multiplies the even 32-bit lanes (0, 2, 4, 6),
+// sign extended to 64 bits; multiplying by 1 is how the ints are
+// widened for the 64-bit sums.  Shifting each 64-bit lane right by 32
+// first brings the odd lanes down into the even ones.
+__attribute__((target("avx2")))
+static void int_stats_avx2(const int32_t *data, size_t n, IntStats *s) {
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i zero = _mm256_setzero_si256();
+	__m256i vmin = _mm256_set1_epi32(s->min);
+	__m256i vmax = _mm256_set1_epi32(s->max);
+	__m256i even_positions = zero, odd_positions = zero, even_values = zero;
+	int64_t evens = 0;
+
+	size_t i = 0;
+	while (i + 8 <= n) {
+		size_t end = n - n % 8;
+		if ((end - i) / 8 > LANE_COUNT_BLOCK) {
+			end = i + 8 * LANE_COUNT_BLOCK;
+		}
+		__m256i vevens = zero;
+		for (; i < end; i += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i *) &data[i]);
+			vmin = _mm256_min_epi32(vmin, v);
+			vmax = _mm256_max_epi32(vmax, v);
+			even_positions = _mm256_add_epi64(even_positions, _mm256_mul_epi32(v, one));
+			odd_positions = _mm256_add_epi64(odd_positions,
+				_mm256_mul_epi32(_mm256_srli_epi64(v, 32), one));
+
+			__m256i even = _mm256_cmpeq_epi32(_mm256_and_si256(v, one), zero);
+			vevens = _mm256_sub_epi32(vevens, even);
+			__m256i ev = _mm256_and_si256(v, even);
+			even_values = _mm256_add_epi64(even_values, _mm256_mul_epi32(ev, one));
+			even_values = _mm256_add_epi64(even_values,
+				_mm256_mul_epi32(_mm256_srli_epi64(ev, 32), one));
+		}
+		evens += sum_counts(vevens);
+	}
+
+	int32_t mins[8], maxs[8];
+	_mm256_storeu_si256((__m256i *) mins, vmin);
+	_mm256_storeu_si256((__m256i *) maxs, vmax);
+	for (int k = 0; k < 8; k++) {
+		s->min = (mins[k] < s->min) ? mins[k] : s->min;
+		s->max = (maxs[k] > s->max) ? maxs[k] : s->max;
+	}
+	int64_t even_position_sum = sum_lanes(even_positions);
+	s->count += i;
+	s->sum += even_position_sum + sum_lanes(odd_positions);
+	s->evens += evens;
+	s->even_sum += sum_lanes(even_values);
+	s->even_position_sum += even_position_sum;
+	_mm256_zeroupper();
+
+	// leftover values at the end (i is a multiple of 8, so even
+	// positions stay even)
+	int_stats_scalar(&data[i], n - i, s);
+}
+
+__attribute__((target("avx2")))
+static int64_t int_count_between_avx2(const int32_t *data, size_t n, int32_t lo, int32_t hi) {
+	const __m256i vlo = _mm256_set1_epi32(lo);
+	const __m256i vhi = _mm256_set1_epi32(hi);
+	const __m256i all = _mm256_set1_epi32(-1);
+	int64_t count = 0;
+
+	size_t i = 0;
+	while (i + 8 <= n) {
+		size_t end = n - n % 8;
+		if ((end - i) / 8 > LANE_COUNT_BLOCK) {
+			end = i + 8 * LANE_COUNT_BLOCK;
+		}
+		__m256i vcount = _mm256_setzero_si256();
+		for (; i < end; i += 8) {
+			__m256i v = _mm256_loadu_si256((const __m256i *) &data[i]);
+			__m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, v), _mm256_cmpgt_epi32(v, vhi));
+			vcount = _mm256_sub_epi32(vcount, _mm256_andnot_si256(out, all));
+		}
+		count += sum_counts(vcount);
+	}
+	_mm256_zeroupper();
+	return count + int_count_between_scalar(&data[i], n - i, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static double int_squared_deviations_avx2(const int32_t *data, size_t n, double mean) {
+	const __m256d vmean = _mm256_set1_pd(mean);
+	__m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i v = _mm256_loadu_si256((const __m256i *) &data[i]);
+		__m256d a = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_castsi256_si128(v)), vmean);
+		__m256d b = _mm256_sub_pd(_mm256_cvtepi32_pd(_mm256_extracti128_si256(v, 1)), vmean);
+		sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(a, a));
+		sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(b, b));
+	}
+
+	double sums[4];
+	_mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+	_mm256_zeroupper();
+	return (sums[0] + sums[1]) + (sums[2] + sums[3])
+		+ int_squared_deviations_scalar(&data[i], n - i, mean);
+}
+
+__attribute__((target("avx2")))
+static void double_stats_avx2(const double *data, size_t n, DoubleStats *s) {
+	__m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+	__m256d vmin = _mm256_set1_pd(s->min);
+	__m256d vmax = _mm256_set1_pd(s->max);
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256d a = _mm256_loadu_pd(&data[i]);
+		__m256d b = _mm256_loadu_pd(&data[i+4]);
+		sum0 = _mm256_add_pd(sum0, a);
+		sum1 = _mm256_add_pd(sum1, b);
+		vmin = _mm256_min_pd(vmin, _mm256_min_pd(a, b));
+		vmax = _mm256_max_pd(vmax, _mm256_max_pd(a, b));
+	}
+
+	double sums[4], mins[4], maxs[4];
+	_mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+	_mm256_storeu_pd(mins, vmin);
+	_mm256_storeu_pd(maxs, vmax);
+	s->count += i;
+	s->sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+	for (int k = 0; k < 4; k++) {
+		s->min = (mins[k] < s->min) ? mins[k] : s->min;
+		s->max = (maxs[k] > s->max) ? maxs[k] : s->max;
+	}
+	_mm256_zeroupper();
+
+	double_stats_scalar(&data[i], n - i, s);
+}
+
+__attribute__((target("avx2")))
+static int64_t double_count_between_avx2(const double *data, size_t n, double lo, double hi) {
+	const __m256d vlo = _mm256_set1_pd(lo);
+	const __m256d vhi = _mm256_set1_pd(hi);
+	int64_t count = 0;
+
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d v = _mm256_loadu_pd(&data[i]);
+		__m256d in = _mm256_and_pd(_mm256_cmp_pd(v, vlo, _CMP_GE_OQ), _mm256_cmp_pd(v, vhi, _CMP_LE_OQ));
+		count += __builtin_popcount(_mm256_movemask_pd(in));
+	}
+	_mm256_zeroupper();
+	return count + double_count_between_scalar(&data[i], n - i, lo, hi);
+}
+
+__attribute__((target("avx2")))
+static double squared_deviations_avx2(const double *data, size_t n, double mean) {
+	const __m256d vmean = _mm256_set1_pd(mean);
+	__m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256d a = _mm256_sub_pd(_mm256_loadu_pd(&data[i]), vmean);
+		__m256d b = _mm256_sub_pd(_mm256_loadu_pd(&data[i+4]), vmean);
+		sum0 = _mm256_add_pd(sum0, _mm256_mul_pd(a, a));
+		sum1 = _mm256_add_pd(sum1, _mm256_mul_pd(b, b));
+	}
+
+	double sums[4];
+	_mm256_storeu_pd(sums, _mm256_add_pd(sum0, sum1));
+	_mm256_zeroupper();
+	return (sums[0] + sums[1]) + (sums[2] + sums[3])
+		+ squared_deviations_scalar(&data[i], n - i, mean);
+}
+
+static const ReduceKernels avx2_kernels = {
+	int_stats_avx2,
+	int_count_between_avx2,
+	int_squared_deviations_avx2,
+	double_stats_avx2,
+	double_count_between_avx2,
+	squared_deviations_avx2,
+};
+#endif
+
+// The widest instruction set supported by the CPU we are running on
+int simd_best(void) {
+#ifdef HAVE_X86_SIMD
+	if (__builtin_cpu_supports("avx2")) {
+		return SIMD_AVX2;
+	}
+#endif
+	return SIMD_SCALAR;
+}
+
+// Turn a requested instruction set into one that can actually be used:
+// SIMD_AUTO, or anything wider than the CPU supports, becomes the
+// widest supported one.
+int simd_resolve(int level) {
+	int best = simd_best();
+	if (level == SIMD_AUTO || level > best) {
+		return best;
+	}
+	return level;
+}
+
+const char *simd_name(int level) {
+	switch (level) {
+	case SIMD_AVX2:
+		return "avx2";
+	default:
+		return "scalar";
+	}
+}
+
+const ReduceKernels *reduce_kernels(int level) {
+	switch (simd_resolve(level)) {
+#ifdef HAVE_X86_SIMD
+	case SIMD_AVX2:
+		return &avx2_kernels;
+#endif
+	default:
+		return &scalar_kernels;
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Instruction sets the reductions can be compiled for
+enum SimdLevel {
+	SIMD_AUTO = -1,   // use the widest one this CPU supports
+	SIMD_SCALAR = 0,
+	SIMD_AVX2 = 1
+};
+
+// Statistics of an array of ints, as random-array-stats.cpp computes
+// them.  The odd values, and the values at odd positions, are what is
+// left over: their count is count - evens, and their sum is
+// sum - even_sum (or sum - even_position_sum).
+struct IntStats {
+	int64_t count;
+	int64_t sum;
+	int32_t min;
+	int32_t max;
+	int64_t evens;              // how many of the values are even
+	int64_t even_sum;           // sum of the even values
+	int64_t even_position_sum;  // sum of data[0], data[2], data[4], ...
+};
+
+// Statistics of an array of doubles
+struct DoubleStats {
+	int64_t count;
+	double sum;
+	double min;
+	double max;
+};
+
+// The reductions, each compiled for one instruction set.  The stats
+// ones add the array to what is already in s, counting positions from
+// the start of the array; to reduce an array a piece at a time, reduce
+// each piece into an IntStats of its own and merge them in order with
+// int_stats_merge.
+struct ReduceKernels {
+	void (*int_stats)(const int32_t *data, size_t n, IntStats *s);
+	// how many of the values are from lo to hi (inclusive)
+	int64_t (*int_count_between)(const int32_t *data, size_t n, int32_t lo, int32_t hi);
+	// the sum of (data[i] - mean)^2
+	double (*int_squared_deviations)(const int32_t *data, size_t n, double mean);
+	void (*double_stats)(const double *data, size_t n, DoubleStats *s);
+	int64_t (*double_count_between)(const double *data, size_t n, double lo, double hi);
+	double (*squared_deviations)(const double *data, size_t n, double mean);
+};
+
+void int_stats_init(IntStats *s);
+void int_stats_merge(IntStats *a, const IntStats *b);
+void double_stats_init(DoubleStats *s);
+
+int simd_best(void);
+int simd_resolve(int level);
+const char *simd_name(int level);
+
+// The reductions for an instruction set (or the widest supported one,
+// see simd_resolve)
+const ReduceKernels *reduce_kernels(int level);
+
+#endif // REDUCE_H
@@ -0,0 +1,207 @@
+// Summarize a list of numbers: how many there are, their sum, the
+// smallest and largest, the mean and the variance.
+//
+//   stats.exe [-s scalar|avx2|auto] [-j THREADS] [FILE...]
+//
+// The numbers, separated by spaces or newlines, are read from each
+// FILE in turn, or from standard input if there are none (or the FILE
+// is -).  For example
+//
+//   seq 1 1000000 | ./stats.exe
+//
+// The files are read with a ValueReader (see valread.cpp), which maps
+// them into memory when it can, and reports the line of anything that
+// isn't a number.
+//
+// quiz_stats.cpp and the temperature examples keep the values in an
+// array of a fixed size, and go through it once for each statistic.
+// This keeps only a running summary (see accumulator.cpp), updated as
+// each value is read, so there can be any number of values.  The
+// values are read a block at a time, and each block is added with the
+// reductions in reduce.cpp, for the instruction set chosen with -s
+// (default the widest the CPU has).
+//
+// With -j, the values are all kept in memory instead, and summarized
+// once they have been read by THREADS threads (see parallel.cpp).
+// Having them all also allows a second pass, which counts the values
+// within 50% of the mean, as random-array-stats.cpp does.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "accumulator.h"
+#include "parallel.h"
+#include "valread.h"
+
+// Where the values read go
+struct Values {
+	Accumulator acc;               // the running summary
+	const ReduceKernels *kernels;
+	bool keep;                     // keep the values instead (for -j)
+	double *kept;
+	size_t nkept;
+	size_t capacity;
+};
+
+bool parse_options(int argc, char *argv[], ReduceParams *params, bool *keep, int *first);
+bool read_values(FILE *file, const char *name, Values *values);
+bool add_values(Values *values, const double *block, size_t n);
+void print_summary(const Accumulator *acc);
+void usage(void);
+
+int main(int argc, char *argv[]) {
+	ReduceParams params;
+	Values values;
+	int first;
+	if (!parse_options(argc, argv, &params, &values.keep, &first)) {
+		usage();
+		return 1;
+	}
+	accumulator_init(&values.acc);
+	values.kernels = reduce_kernels(params.simd);
+	values.kept = NULL;
+	values.nkept = 0;
+	values.capacity = 0;
+
+	bool ok = true;
+	if (first == argc) {
+		ok = read_values(stdin, "standard input", &values);
+	}
+	for (int i = first; i < argc && ok; i++) {
+		if (strcmp(argv[i], "-") == 0) {
+			ok = read_values(stdin, "standard input", &values);
+			continue;
+		}
+		FILE *file = fopen(argv[i], "r");
+		if (file == NULL) {
+			printf("Can't read %s\n", argv[i]);
+			free(values.kept);
+			return 1;
+		}
+		ok = read_values(file, argv[i], &values);
+		fclose(file);
+	}
+	if (!ok) {
+		free(values.kept);
+		return 1;
+	}
+
+	if (!values.keep) {
+		print_summary(&values.acc);
+		return 0;
+	}
+	DoubleSummary summary;
+	ok = summarize_doubles(values.kept, values.nkept, &params, &summary);
+	free(values.kept);
+	if (!ok) {
+		printf("Not enough memory for %i threads\n", params.nthreads);
+		return 1;
+	}
+	print_summary(&summary.acc);
+	if (summary.acc.count > 0) {
+		printf("Near mean:  %lli (within 50%%)\n", (long long) summary.near_mean);
+	}
+	return 0;
+}
+
+// Read the options before the files, setting *keep if the values are
+// to be kept (-j), and *first to the argument after the options.
+bool parse_options(int argc, char *argv[], ReduceParams *params, bool *keep, int *first) {
+	reduce_params_init(params);
+	*keep = false;
+
+	int i = 1;
+	for (; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; i += 2) {
+		if (i + 1 >= argc) {
+			return false;
+		}
+		const char *value = argv[i+1];
+		if (strcmp(argv[i], "-s") == 0) {
+			if (strcmp(value, "scalar") == 0) {
+				params->simd = SIMD_SCALAR;
+			} else if (strcmp(value, "avx2") == 0) {
+				params->simd = SIMD_AVX2;
+			} else if (strcmp(value, "auto") == 0) {
+				params->simd = SIMD_AUTO;
+			} else {
+				return false;
+			}
+		} else if (strcmp(argv[i], "-j") == 0) {
+			params->nthreads = atoi(value);
+			*keep = true;
+		} else {
+			return false;
+		}
+	}
+	*first = i;
+	return params->nthreads >= 1;
+}
+
+// Add every number in a file to values.
+// Returns false (after printing what was wrong) if the file has
+// something that isn't a number, or there isn't enough memory to keep
+// the values.
+bool read_values(FILE *file, const char *name, Values *values) {
+	ValueReader reader;
+	value_reader_init(&reader, file, name);
+	value_reader_map(&reader);
+
+	double block[REDUCE_BLOCK];
+	size_t n = 0;
+	int got = 0;
+	bool ok = true;
+	while (ok && (got = value_reader_next_double(&reader, &block[n])) == 1) {
+		if (++n == REDUCE_BLOCK) {
+			ok = add_values(values, block, n);
+			n = 0;
+		}
+	}
+	value_reader_close(&reader);
+	return ok && add_values(values, block, n) && got == 0;
+}
+
+// Add a block of n values to the summary, or to the ones kept.
+// Returns false (after printing why) if there isn't enough memory to
+// keep them.
+bool add_values(Values *values, const double *block, size_t n) {
+	if (!values->keep) {
+		accumulator_add_values(&values->acc, block, n, values->kernels);
+		return true;
+	}
+	if (values->nkept + n > values->capacity) {
+		size_t capacity = values->capacity > 0 ? 2 * values->capacity : REDUCE_BLOCK;
+		double *kept = (double *) realloc(values->kept, capacity * sizeof(double));
+		if (kept == NULL) {
+			printf("Not enough memory for %llu values\n", (unsigned long long) capacity);
+			return false;
+		}
+		values->kept = kept;
+		values->capacity = capacity;
+	}
+	memcpy(&values->kept[values->nkept], block, n * sizeof(double));
+	values->nkept += n;
+	return true;
+}
+
+void print_summary(const Accumulator *acc) {
+	printf("Count:      %li\n", acc->count);
+	if (acc->count == 0) {
+		return;
+	}
+	printf("Sum:        %.15g\n", accumulator_sum(acc));
+	printf("Min:        %.15g\n", acc->min);
+	printf("Max:        %.15g\n", acc->max);
+	printf("Mean:       %.15g\n", acc->mean);
+	printf("Variance:   %.15g (sample %.15g)\n", accumulator_variance(acc),
+		accumulator_sample_variance(acc));
+	printf("Std dev:    %.15g\n", sqrt(accumulator_variance(acc)));
+}
+
+void usage(void) {
+	printf("Usage: stats.exe [-s scalar|avx2|auto] [-j THREADS] [FILE...]\n");
+	printf("  FILE...     files of numbers to summarize (default standard input)\n");
+	printf("  -s SIMD     instruction set for the sums (default: widest supported)\n");
+	printf("  -j THREADS  keep the values, and summarize them with THREADS threads\n");
+	printf("              (also counting the values within 50%% of the mean)\n");
+}
@@ -0,0 +1,265 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "valread.h"
+
+// Longest word that is converted with strtod when it isn't a plain
+// decimal number (like 1e-300, or 0x1p-3)
+#define MAX_SLOW_WORD 128
+
+// Powers of ten that are exact as doubles
+static const double powers_of_ten[] = {
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+void value_reader_init(ValueReader *r, FILE *file, const char *name) {
+	r->file = file;
+	r->name = name;
+	r->text = r->buf;
+	r->pos = 0;
+	r->len = 0;
+	r->eof = false;
+	r->map = NULL;
+	r->map_size = 0;
+	r->line = 1;
+}
+
+// Map the whole file into memory, to take the numbers straight from
+// it instead of reading it a block at a time.  Only a regular file
+// that nothing has been read from yet can be mapped.
+// Returns false if the file can't be mapped, in which case it is read
+// in blocks.
+bool value_reader_map(ValueReader *r) {
+	struct stat st;
+	int fd = fileno(r->file);
+	if (r->len > 0 || fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size == 0
+			|| ftell(r->file) != 0) {
+		return false;
+	}
+	void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		return false;
+	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
+	r->map = map;
+	r->map_size = st.st_size;
+	r->text = (const char *) map;
+	r->len = st.st_size;
+	r->eof = true;
+	// leave the file at its end, as if it had been read
+	fseek(r->file, 0, SEEK_END);
+	return true;
+}
+
+void value_reader_close(ValueReader *r) {
+	if (r->map != NULL) {
+		munmap(r->map, r->map_size);
+		r->map = NULL;
+	}
+}
+
+static inline bool is_space(char c) {
+	return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline bool is_digit(char c) {
+	return c >= '0' && c <= '9';
+}
+
+// Move what is left of the buffer to its start, and read more after it.
+// Returns false if nothing more could be read (at the end of the file,
+// or if the buffer is full).
+static bool fill(ValueReader *r) {
+	if (r->eof) {
+		return false;
+	}
+	size_t left = r->len - r->pos;
+	memmove(r->buf, &r->buf[r->pos], left);
+	r->pos = 0;
+	r->len = left;
+	size_t want = VALUE_BUFFER_SIZE - left;
+	size_t got = fread(&r->buf[left], 1, want, r->file);
+	r->eof = got < want;
+	r->len += got;
+	return got > 0;
+}
+
+// Find the next word (everything up to the white space after it),
+// setting *word to its start and *len to its length.  The word is
+// taken as read.
+// Returns false at the end of the file.
+static bool next_word(ValueReader *r, const char **word, size_t *len) {
+	for (;;) {
+		while (r->pos < r->len && is_space(r->text[r->pos])) {
+			if (r->text[r->pos] == '\n') {
+				r->line++;
+			}
+			r->pos++;
+		}
+		if (r->pos < r->len) {
+			break;
+		}
+		if (!fill(r)) {
+			return false;
+		}
+	}
+
+	// the whole word has to be in the buffer
+	size_t n = 0;
+	for (;;) {
+		while (r->pos + n < r->len && !is_space(r->text[r->pos + n])) {
+			n++;
+		}
+		if (r->pos + n < r->len || !fill(r)) {
+			break;
+		}
+	}
+	*word = &r->text[r->pos];
+	*len = n;
+	r->pos += n;
+	return true;
+}
+
+static void not_a_number(const ValueReader *r, const char *word, size_t len) {
+	printf("%s, line %li: %.*s is not a number\n", r->name, r->line,
+		len > 40 ? 40 : (int) len, word);
+}
+
+// Read the next number, a whole number written in decimal, into x.
+// Returns 1 if there was one, 0 at the end of the file, or -1 (after
+// printing the line number and what was wrong) if the next word isn't
+// a whole number that fits in 64 bits.
+int value_reader_next_int(ValueReader *r, int64_t *x) {
+	const char *word;
+	size_t len;
+	if (!next_word(r, &word, &len)) {
+		return 0;
+	}
+
+	size_t i = 0;
+	bool negative = false;
+	if (word[0] == '-' || word[0] == '+') {
+		negative = word[0] == '-';
+		i++;
+	}
+	if (i == len) {
+		not_a_number(r, word, len);
+		return -1;
+	}
+	// the magnitude, which can be one more than INT64_MAX if negative
+	uint64_t limit = negative ? (uint64_t) INT64_MAX + 1 : INT64_MAX;
+	uint64_t value = 0;
+	for (; i < len; i++) {
+		if (!is_digit(word[i])) {
+			not_a_number(r, word, len);
+			return -1;
+		}
+		uint64_t digit = word[i] - '0';
+		if (value > (limit - digit) / 10) {
+			printf("%s, line %li: %.*s is too big\n", r->name, r->line,
+				len > 40 ? 40 : (int) len, word);
+			return -1;
+		}
+		value = value * 10 + digit;
+	}
+	*x = negative ? (int64_t) (0 - value) : (int64_t) value;
+	return 1;
+}
+
+// Read the next number into x.
+// Returns 1 if there was one, 0 at the end of the file, or -1 (after
+// printing the line number and what was wrong) if the next word isn't
+// a number.
+//
+// Most numbers are plain decimals like 98.6 or -1.5e3, with at most 19
+// digits.  They are read as a whole number m of up to 19 digits and a
+// power of ten e (98.6 is 986 and -1): if m is at most 2^53 and e at
+// most 22 either way, then m and 10^e are both exact doubles, and
+// m * 10^e (or m / 10^-e) is rounded only once, so it is the closest
+// double to the number, as strtod gives.  Anything else is left to
+// strtod.
+int value_reader_next_double(ValueReader *r, double *x) {
+	const char *word;
+	size_t len;
+	if (!next_word(r, &word, &len)) {
+		return 0;
+	}
+
+	size_t i = 0;
+	bool negative = false;
+	if (word[0] == '-' || word[0] == '+') {
+		negative = word[0] == '-';
+		i++;
+	}
+	uint64_t m = 0;
+	int digits = 0;       // significant digits in m
+	int exponent = 0;
+	bool any = false;     // any digits at all
+	for (; i < len && is_digit(word[i]); i++) {
+		m = m * 10 + (word[i] - '0');
+		digits += (m > 0);
+		any = true;
+	}
+	if (i < len && word[i] == '.') {
+		for (i++; i < len && is_digit(word[i]); i++) {
+			m = m * 10 + (word[i] - '0');
+			digits += (m > 0);
+			exponent--;
+			any = true;
+		}
+	}
+	if (any && i < len && (word[i] == 'e' || word[i] == 'E')) {
+		size_t j = i + 1;
+		bool negative_exponent = false;
+		if (j < len && (word[j] == '-' || word[j] == '+')) {
+			negative_exponent = word[j] == '-';
+			j++;
+		}
+		int e = 0;
+		bool exponent_digits = false;
+		for (; j < len && is_digit(word[j]) && e < 10000; j++) {
+			e = e * 10 + (word[j] - '0');
+			exponent_digits = true;
+		}
+		if (exponent_digits) {
+			exponent += negative_exponent ? -e : e;
+			i = j;
+		}
+	}
+
+	if (any && i == len && digits <= 19) {
+		if (m == 0) {
+			*x = negative ? -0.0 : 0.0;
+			return 1;
+		}
+		if (m <= ((uint64_t) 1 << 53) && exponent >= -22 && exponent <= 22) {
+			double value = (double) m;
+			if (exponent < 0) {
+				value /= powers_of_ten[-exponent];
+			} else {
+				value *= powers_of_ten[exponent];
+			}
+			*x = negative ? -value : value;
+			return 1;
+		}
+	}
+
+	// the slow way
+	char text[MAX_SLOW_WORD + 1];
+	if (len > MAX_SLOW_WORD) {
+		not_a_number(r, word, len);
+		return -1;
+	}
+	memcpy(text, word, len);
+	text[len] = '\0';
+	char *end;
+	double value = strtod(text, &end);
+	if (end != &text[len]) {
+		not_a_number(r, word, len);
+		return -1;
+	}
+	*x = value;
+	return 1;
+}
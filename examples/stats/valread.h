@@ -0,0 +1,38 @@
+#ifndef VALREAD_H
+#define VALREAD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+// Size of a ValueReader's buffer, which is also the longest word it
+// can read
+#define VALUE_BUFFER_SIZE (1 << 16)
+
+// Reads numbers, ints or doubles, separated by any white space, from a
+// file.  The file is mapped into memory, or read in large blocks, and
+// the numbers are converted here: scanf("%lf") per number spends most
+// of its time working out the format and the locale.  Line numbers
+// are kept for error messages.  Ints are read in decimal only, as
+// scanf("%d") does: unlike "%i", a leading 0 or 0x doesn't make them
+// octal or hex.
+struct ValueReader {
+	FILE *file;
+	const char *name;   // for error messages
+	const char *text;   // the mapped file, or buf
+	size_t pos;
+	size_t len;
+	bool eof;           // nothing more to read into buf
+	void *map;          // NULL if the file isn't mapped
+	size_t map_size;
+	long line;
+	char buf[VALUE_BUFFER_SIZE];
+};
+
+void value_reader_init(ValueReader *r, FILE *file, const char *name);
+bool value_reader_map(ValueReader *r);
+void value_reader_close(ValueReader *r);
+int value_reader_next_int(ValueReader *r, int64_t *x);
+int value_reader_next_double(ValueReader *r, double *x);
+
+#endif // VALREAD_H